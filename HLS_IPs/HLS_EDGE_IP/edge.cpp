@@ -0,0 +1,279 @@
+#include "edge.hpp"
+
+
+static int clamp_index(int i, int size) {
+	return (i < 0) ? 0 : ((i >= size) ? size - 1 : i);
+}
+
+static int abs_int(int v) {
+	return (v < 0) ? -v : v;
+}
+
+// cvRound: nearest integer, halfway cases to even
+static int round_even(float v) {
+	int i = (int)v;
+	if (v < (float)i)
+		i--;
+	float frac = v - (float)i;
+	if (frac > 0.5f || (frac == 0.5f && (i & 1)))
+		i++;
+	return i;
+}
+
+
+
+// Luma of a YUYV pixel (words of two pixels: Y0 U Y1 V, little endian), the cv::COLOR_YUV2GRAY_YUY2 result
+uint8_t yuyv_gray(const uint32_t *frame, int stride, int x, int y) {
+	uint32_t word = frame[y * stride + (x >> 1)];
+	return (x & 1) ? (word >> 16) & 0xff : word & 0xff;
+}
+
+
+
+// Grayscale conversion and inverted binary threshold of one ROI row (cv::THRESH_BINARY_INV: the dark bolt
+// becomes binary_max)
+void threshold_row(const uint32_t *frame, int stride, int roi_x, int y, int width, int threshold, uint8_t binary[max_width]) {
+	col: for (int x = 0; x < width; x++) {
+#pragma HLS LOOP_TRIPCOUNT max=max_width
+#pragma HLS PIPELINE II=1
+		binary[x] = (yuyv_gray(frame, stride, roi_x + x, y) > threshold) ? 0 : binary_max;
+	}
+	return;
+}
+
+
+
+// 3x3 Sobel derivatives of one row and their L1 magnitude, the borders replicated as in cv::Canny
+void sobel_row(const uint8_t above[max_width], const uint8_t row[max_width], const uint8_t below[max_width], int width,
+		int16_t dx[max_width], int16_t dy[max_width], int16_t mag[max_width]) {
+	col: for (int x = 0; x < width; x++) {
+#pragma HLS LOOP_TRIPCOUNT max=max_width
+#pragma HLS PIPELINE II=1
+		int l = clamp_index(x - 1, width);
+		int r = clamp_index(x + 1, width);
+		int gx = (above[r] - above[l]) + 2 * (row[r] - row[l]) + (below[r] - below[l]);
+		int gy = (below[l] + 2 * below[x] + below[r]) - (above[l] + 2 * above[x] + above[r]);
+		dx[x] = gx;
+		dy[x] = gy;
+		mag[x] = abs_int(gx) + abs_int(gy);
+	}
+	return;
+}
+
+
+
+// Non-maximum suppression of cv::Canny along the gradient direction. The magnitudes outside of the ROI are 0
+// (first / last: no row above / below).
+// On a binary image every non-zero magnitude is a multiple of binary_max, above canny_high: all the local
+// maxima are strong edges and the hysteresis of cv::Canny has nothing left to decide.
+void edge_row(const int16_t mag_above[max_width], const int16_t mag[max_width], const int16_t mag_below[max_width],
+		const int16_t dx[max_width], const int16_t dy[max_width], int width, bool first, bool last, uint8_t edges[max_width]) {
+	col: for (int x = 0; x < width; x++) {
+#pragma HLS LOOP_TRIPCOUNT max=max_width
+#pragma HLS PIPELINE II=1
+		int m = mag[x];
+		int left = (x > 0) ? mag[x - 1] : 0;
+		int right = (x + 1 < width) ? mag[x + 1] : 0;
+		bool edge = false;
+
+		if (m > canny_low) {
+			int xs = abs_int(dx[x]);
+			int ys = abs_int(dy[x]) << canny_shift;
+			int tg22x = xs * canny_tg22;
+			int tg67x = tg22x + (xs << (canny_shift + 1));
+
+			if (ys < tg22x) {
+				// Horizontal gradient
+				edge = m > left && m >= right;
+			}
+			else if (ys > tg67x) {
+				// Vertical gradient
+				int above = first ? 0 : mag_above[x];
+				int below = last ? 0 : mag_below[x];
+				edge = m > above && m >= below;
+			}
+			else {
+				// Diagonal gradient
+				int s = ((dx[x] ^ dy[x]) < 0) ? -1 : 1;
+				int xa = x - s;
+				int xb = x + s;
+				int above = (!first && xa >= 0 && xa < width) ? mag_above[xa] : 0;
+				int below = (!last && xb >= 0 && xb < width) ? mag_below[xb] : 0;
+				edge = m > above && m > below;
+			}
+		}
+		edges[x] = edge ? binary_max : 0;
+	}
+	return;
+}
+
+
+
+// Votes of the edge pixels of one row for the lines through them, over the angle bins
+// [theta_first, theta_first + theta_count[ only
+void hough_vote(const uint8_t edges[max_width], int y, int width, int rho_offset, int theta_first, int theta_count,
+		uint16_t accumulator[n_theta][max_rho]) {
+	col: for (int x = 0; x < width; x++) {
+#pragma HLS LOOP_TRIPCOUNT max=max_width
+#pragma HLS PIPELINE II=1
+		if (edges[x] == 0)
+			continue;
+		theta: for (int n = 0; n < n_theta; n++) {
+#pragma HLS UNROLL
+			if (n < theta_first || n >= theta_first + theta_count)
+				continue;
+			int r = round_even(x * hough::cos_theta[n] + y * hough::sin_theta[n]) + rho_offset;
+			accumulator[n][r]++;
+		}
+	}
+	return;
+}
+
+
+
+// Local maxima of the accumulator above hough_threshold, strongest first (ties in cv::HoughLines order).
+// Returns the number of maxima, of which the max_lines strongest are written.
+int hough_peaks(const uint16_t accumulator[n_theta][max_rho], int num_rho, int rho_offset, int hough_threshold,
+		int line_theta[max_lines], int line_rho[max_lines], int line_votes[max_lines]) {
+	int num_peaks = 0;
+
+	rho: for (int r = 0; r < num_rho; r++) {
+#pragma HLS LOOP_TRIPCOUNT max=max_rho
+		theta: for (int n = 0; n < n_theta; n++) {
+#pragma HLS PIPELINE II=2
+			int votes = accumulator[n][r];
+			int left = (r > 0) ? accumulator[n][r - 1] : 0;
+			int right = (r + 1 < num_rho) ? accumulator[n][r + 1] : 0;
+			int up = (n > 0) ? accumulator[n - 1][r] : 0;
+			int down = (n + 1 < n_theta) ? accumulator[n + 1][r] : 0;
+			if (!(votes > hough_threshold && votes > left && votes >= right && votes > up && votes >= down))
+				continue;
+
+			// Insertion in the strongest lines, in order of votes then of angle bin then of distance
+			int count = (num_peaks < max_lines) ? num_peaks : max_lines;
+			int pos = count;
+			find: for (int i = 0; i < max_lines; i++) {
+#pragma HLS UNROLL
+				if (i < count && pos == count) {
+					bool before = votes > line_votes[i] ||
+						(votes == line_votes[i] && (n < line_theta[i] || (n == line_theta[i] && r - rho_offset < line_rho[i])));
+					if (before)
+						pos = i;
+				}
+			}
+			shift: for (int i = max_lines - 1; i > 0; i--) {
+#pragma HLS UNROLL
+				if (i > pos) {
+					line_theta[i] = line_theta[i - 1];
+					line_rho[i] = line_rho[i - 1];
+					line_votes[i] = line_votes[i - 1];
+				}
+			}
+			if (pos < max_lines) {
+				line_theta[pos] = n;
+				line_rho[pos] = r - rho_offset;
+				line_votes[pos] = votes;
+			}
+			num_peaks++;
+		}
+	}
+	return num_peaks;
+}
+
+
+
+// Bolt edges and their dominant lines in a ROI of a YUYV frame:
+// YUYV -> gray -> inverted threshold -> Sobel -> Canny non-maximum suppression -> Hough accumulator.
+// frame: YUYV frame in DDR, stride in 32-bit words (2 pixels each), roi_x even.
+// Returns the number of lines above hough_threshold; the strongest ones are in line_theta (angle bin of
+// 180 / n_theta degrees), line_rho (pixels from the ROI origin) and line_votes.
+// With debug_edges set, the edge image of the ROI is also written to edges (roi_width bytes per row).
+int edge_angle(const uint32_t *frame, uint8_t *edges, int stride, int roi_x, int roi_y, int roi_width, int roi_height,
+		int threshold, int theta_first, int theta_count, int hough_threshold, int debug_edges,
+		int line_theta[max_lines], int line_rho[max_lines], int line_votes[max_lines]) {
+
+#pragma HLS INTERFACE m_axi port=frame offset=slave bundle=FRAME depth=153600
+#pragma HLS INTERFACE m_axi port=edges offset=slave bundle=EDGES depth=307200
+#pragma HLS INTERFACE s_axilite port=frame bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=edges bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=stride bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=roi_x bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=roi_y bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=roi_width bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=roi_height bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=threshold bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=theta_first bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=theta_count bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=hough_threshold bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=debug_edges bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=line_theta bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=line_rho bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=line_votes bundle=AXI_CPU
+#pragma HLS INTERFACE s_axilite port=return bundle=AXI_CPU
+
+	// Rows y - 1, y and y + 1 of each stage, indexed by row % 3
+	static uint8_t binary[3][max_width];
+	static int16_t dx[3][max_width];
+	static int16_t dy[3][max_width];
+	static int16_t mag[3][max_width];
+	static uint8_t edge_line[max_width];
+	static uint16_t accumulator[n_theta][max_rho];
+#pragma HLS ARRAY_PARTITION variable=binary complete dim=1
+#pragma HLS ARRAY_PARTITION variable=dx complete dim=1
+#pragma HLS ARRAY_PARTITION variable=dy complete dim=1
+#pragma HLS ARRAY_PARTITION variable=mag complete dim=1
+#pragma HLS ARRAY_PARTITION variable=accumulator complete dim=1
+
+	if (roi_width > max_width)
+		roi_width = max_width;
+	if (roi_height > max_height)
+		roi_height = max_height;
+	if (theta_first < 0)
+		theta_first = 0;
+	if (theta_first + theta_count > n_theta)
+		theta_count = n_theta - theta_first;
+	roi_x &= ~1;
+
+	// Distance bins of cv::HoughLines for the ROI size
+	int num_rho = 2 * (roi_width + roi_height) + 1;
+	int rho_offset = (num_rho - 1) / 2;
+
+	clear_rho: for (int r = 0; r < max_rho; r++) {
+#pragma HLS PIPELINE II=1
+		clear_theta: for (int n = 0; n < n_theta; n++) {
+#pragma HLS UNROLL
+			accumulator[n][r] = 0;
+		}
+	}
+
+	// Row y is thresholded while the Sobel of row y - 1 and the edges of row y - 2 are computed
+	row: for (int y = 0; y < roi_height + 2; y++) {
+#pragma HLS LOOP_TRIPCOUNT max=max_height+2
+		if (y < roi_height) {
+			threshold_row(frame, stride, roi_x, roi_y + y, roi_width, threshold, binary[y % 3]);
+		}
+
+		int s = y - 1;
+		if (s >= 0 && s < roi_height) {
+			sobel_row(binary[clamp_index(s - 1, roi_height) % 3], binary[s % 3], binary[clamp_index(s + 1, roi_height) % 3],
+					roi_width, dx[s % 3], dy[s % 3], mag[s % 3]);
+		}
+
+		int e = y - 2;
+		if (e >= 0) {
+			edge_row(mag[(e + 2) % 3], mag[e % 3], mag[(e + 1) % 3], dx[e % 3], dy[e % 3], roi_width,
+					e == 0, e + 1 == roi_height, edge_line);
+			hough_vote(edge_line, e, roi_width, rho_offset, theta_first, theta_count, accumulator);
+
+			if (debug_edges) {
+				debug: for (int x = 0; x < roi_width; x++) {
+#pragma HLS LOOP_TRIPCOUNT max=max_width
+#pragma HLS PIPELINE II=1
+					edges[e * roi_width + x] = edge_line[x];
+				}
+			}
+		}
+	}
+
+	return hough_peaks(accumulator, num_rho, rho_offset, hough_threshold, line_theta, line_rho, line_votes);
+}
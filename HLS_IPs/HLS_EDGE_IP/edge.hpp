@@ -0,0 +1,59 @@
+#include <stdint.h>
+
+#define max_width 640    // Largest ROI, the camera frame
+#define max_height 480
+#define n_theta 60       // Hough angle bins of 3 degrees over [0, 180[, the resolution of the node HoughLines call
+#define max_rho (2 * (max_width + max_height) + 1) // Hough distance bins of 1 pixel for the largest ROI
+#define max_lines 8      // Strongest lines returned
+#define binary_max 255   // Value of the dark pixels after the inverted threshold
+#define canny_low 50     // Canny thresholds of the node (see edge_row)
+#define canny_high 100
+#define canny_shift 15   // Fixed-point tan(22.5 deg) of cv::Canny
+#define canny_tg22 13573
+
+uint8_t yuyv_gray(const uint32_t *frame, int stride, int x, int y);
+void threshold_row(const uint32_t *frame, int stride, int roi_x, int y, int width, int threshold, uint8_t binary[max_width]);
+void sobel_row(const uint8_t above[max_width], const uint8_t row[max_width], const uint8_t below[max_width], int width,
+		int16_t dx[max_width], int16_t dy[max_width], int16_t mag[max_width]);
+void edge_row(const int16_t mag_above[max_width], const int16_t mag[max_width], const int16_t mag_below[max_width],
+		const int16_t dx[max_width], const int16_t dy[max_width], int width, bool first, bool last, uint8_t edges[max_width]);
+void hough_vote(const uint8_t edges[max_width], int y, int width, int rho_offset, int theta_first, int theta_count,
+		uint16_t accumulator[n_theta][max_rho]);
+int hough_peaks(const uint16_t accumulator[n_theta][max_rho], int num_rho, int rho_offset, int hough_threshold,
+		int line_theta[max_lines], int line_rho[max_lines], int line_votes[max_lines]);
+int edge_angle(const uint32_t *frame, uint8_t *edges, int stride, int roi_x, int roi_y, int roi_width, int roi_height,
+		int threshold, int theta_first, int theta_count, int hough_threshold, int debug_edges,
+		int line_theta[max_lines], int line_rho[max_lines], int line_votes[max_lines]);
+
+
+namespace hough {
+
+	// cos / sin of the angle bins as computed by cv::HoughLines (angle accumulated in float), for the
+	// same rounding of rho
+	const float cos_theta[n_theta] = {
+			1.0f, 0.99862951f, 0.994521916f, 0.987688363f, 0.978147626f, 0.965925813f,
+			0.95105654f, 0.933580399f, 0.91354543f, 0.891006529f, 0.866025388f, 0.838670552f,
+			0.809017003f, 0.777145922f, 0.74314481f, 0.707106769f, 0.669130564f, 0.629320383f,
+			0.587785244f, 0.544638991f, 0.49999997f, 0.453990519f, 0.406736732f, 0.358368099f,
+			0.309017181f, 0.258819312f, 0.207911998f, 0.156434834f, 0.104528897f, 0.0523364507f,
+			5.52335052e-07f, -0.052335348f, -0.104527801f, -0.156433746f, -0.207910925f, -0.258818239f,
+			-0.309016138f, -0.358367056f, -0.406735718f, -0.453989536f, -0.499999017f, -0.544638038f,
+			-0.587784231f, -0.62931937f, -0.66912961f, -0.707105756f, -0.743143857f, -0.777144969f,
+			-0.809016049f, -0.838669658f, -0.866024554f, -0.891005695f, -0.913544714f, -0.933579743f,
+			-0.951055944f, -0.965925336f, -0.978147149f, -0.987688005f, -0.994521677f, -0.998629391f
+	};
+
+	const float sin_theta[n_theta] = {
+			0.0f, 0.0523359589f, 0.104528464f, 0.156434476f, 0.2079117f, 0.258819044f,
+			0.309017003f, 0.35836795f, 0.406736642f, 0.453990519f, 0.5f, 0.544639051f,
+			0.587785244f, 0.629320383f, 0.669130623f, 0.707106769f, 0.74314487f, 0.777145982f,
+			0.809017003f, 0.838670611f, 0.866025448f, 0.891006529f, 0.91354543f, 0.933580399f,
+			0.95105648f, 0.965925753f, 0.978147507f, 0.987688303f, 0.994521856f, 0.99862951f,
+			1.0f, 0.99862957f, 0.994521976f, 0.987688482f, 0.978147745f, 0.965926051f,
+			0.951056778f, 0.933580756f, 0.913545847f, 0.891007006f, 0.866025984f, 0.838671207f,
+			0.809017718f, 0.777146757f, 0.743145764f, 0.707107782f, 0.669131696f, 0.629321575f,
+			0.587786555f, 0.544640422f, 0.50000149f, 0.453992069f, 0.406738311f, 0.358369708f,
+			0.30901885f, 0.258820981f, 0.207913712f, 0.156436563f, 0.104530632f, 0.0523381904f
+	};
+
+}
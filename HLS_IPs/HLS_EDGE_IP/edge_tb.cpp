@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "edge.hpp"
+
+#define frame_width 640
+#define frame_height 480
+#define hough_threshold 30     // Same as the node
+#define gray_threshold 94
+#define background_luma 200
+#define bolt_luma 40
+
+
+// YUYV frame (as 32-bit words) with a dark hexagon of circumradius radius centered on center, rotated by
+// angle degrees, on a light background
+static void hexagon_frame(cv::Point2f center, float radius, float angle, std::vector<uint32_t> &frame, cv::Mat &yuyv) {
+	cv::Mat luma(frame_height, frame_width, CV_8UC1, cv::Scalar(background_luma));
+	std::vector<cv::Point> hexagon;
+	for (int i = 0; i < 6; i++) {
+		float a = (angle + 30.0f + 60.0f * i) * (float)CV_PI / 180.0f;
+		hexagon.push_back(cv::Point(cvRound(center.x + radius * std::cos(a)), cvRound(center.y + radius * std::sin(a))));
+	}
+	cv::fillConvexPoly(luma, hexagon, cv::Scalar(bolt_luma));
+
+	yuyv.create(frame_height, frame_width, CV_8UC2);
+	for (int y = 0; y < frame_height; y++) {
+		for (int x = 0; x < frame_width; x++) {
+			yuyv.at<cv::Vec2b>(y, x) = cv::Vec2b(luma.at<uint8_t>(y, x), (x & 1) ? 120 : 136);
+		}
+	}
+	frame.resize(frame_width * frame_height / 2);
+	memcpy(frame.data(), yuyv.data, frame.size() * sizeof(uint32_t));
+}
+
+// Angle of find_rotation_angle from the lines, strongest first
+static bool lines_angle(const int line_theta[], int num_lines, float &angle) {
+	if (num_lines < 2 || num_lines > 6)
+		return false;
+	float line_angle = 0;
+	for (int i = 0; i < num_lines; i++) {
+		line_angle = line_theta[i] * 180.0f / n_theta;
+		if (line_angle <= 60) {
+			angle = line_angle;
+			return true;
+		}
+	}
+	angle = (int)line_angle % 60;
+	return true;
+}
+
+static int check_hexagon(cv::Point2f center, float radius, float angle, cv::Rect roi) {
+	std::vector<uint32_t> frame;
+	cv::Mat yuyv;
+	hexagon_frame(center, radius, angle, frame, yuyv);
+
+	static uint8_t edges[max_width * max_height];
+	int line_theta[max_lines];
+	int line_rho[max_lines];
+	int line_votes[max_lines];
+	int num_lines = edge_angle(frame.data(), edges, frame_width / 2, roi.x, roi.y, roi.width, roi.height,
+			gray_threshold, 0, n_theta, hough_threshold, 1, line_theta, line_rho, line_votes);
+
+	// OpenCV pipeline of the node on the same ROI
+	cv::Mat gray, binary, cv_edges;
+	cv::cvtColor(yuyv, gray, cv::COLOR_YUV2GRAY_YUY2);
+	for (int y = 0; y < frame_height; y++) {
+		for (int x = 0; x < frame_width; x++) {
+			if (yuyv_gray(frame.data(), frame_width / 2, x, y) != gray.at<uint8_t>(y, x)) {
+				std::cout << "Gray mismatch at " << x << ", " << y << std::endl;
+				return 1;
+			}
+		}
+	}
+	cv::threshold(gray(roi), binary, gray_threshold, 500, cv::THRESH_BINARY_INV);
+	cv::Canny(binary, cv_edges, canny_low, canny_high);
+	int edge_mismatches = 0;
+	for (int y = 0; y < roi.height; y++) {
+		for (int x = 0; x < roi.width; x++) {
+			if (edges[y * roi.width + x] != cv_edges.at<uint8_t>(y, x))
+				edge_mismatches++;
+		}
+	}
+	if (edge_mismatches != 0) {
+		std::cout << edge_mismatches << " edge pixel(s) differ from cv::Canny" << std::endl;
+		return 1;
+	}
+
+	std::vector<cv::Vec3f> cv_lines;
+	cv::HoughLines(cv_edges, cv_lines, 1, CV_PI / n_theta, hough_threshold);
+	if (num_lines != (int)cv_lines.size()) {
+		std::cout << num_lines << " line(s) instead of " << cv_lines.size() << " for cv::HoughLines" << std::endl;
+		return 1;
+	}
+	for (int i = 0; i < num_lines && i < max_lines; i++) {
+		int cv_theta = cvRound(cv_lines[i][1] / (CV_PI / n_theta));
+		if (line_theta[i] != cv_theta || line_rho[i] != cvRound(cv_lines[i][0]) || line_votes[i] != cvRound(cv_lines[i][2])) {
+			std::cout << "Line " << i << " (" << line_theta[i] << ", " << line_rho[i] << ", " << line_votes[i]
+					<< ") instead of (" << cv_theta << ", " << cv_lines[i][0] << ", " << cv_lines[i][2] << ")" << std::endl;
+			return 1;
+		}
+	}
+
+	// Outside of 2 - 6 lines find_rotation_angle skips the contour, as it would with the cv::HoughLines result
+	float estimated;
+	if (!lines_angle(line_theta, num_lines, estimated)) {
+		std::cout << "Hexagon at " << angle << " degrees: " << num_lines << " lines, no angle" << std::endl;
+		return 0;
+	}
+	// The hexagon is symmetric every 60 degrees, the Hough bins are 180 / n_theta degrees wide
+	float error = std::fabs(std::remainder(estimated - angle, 60.0f));
+	if (error > 180.0f / n_theta) {
+		std::cout << "Angle " << estimated << " instead of " << angle << std::endl;
+		return 1;
+	}
+	std::cout << "Hexagon at " << angle << " degrees: " << num_lines << " lines, angle " << estimated << std::endl;
+	return 0;
+}
+
+int main() {
+
+	const float angles[] = {0.0f, 3.3f, 7.0f, 15.0f, 24.0f, 33.0f, 38.0f, 52.0f};
+	cv::Rect full_frame(0, 0, frame_width, frame_height);
+	cv::Rect bolt_roi(240, 160, 160, 160);
+
+	for (float angle : angles) {
+		if (check_hexagon(cv::Point2f(320, 240), 60, angle, bolt_roi) != 0) {
+			std::cout << "Test failed on the bolt ROI" << std::endl;
+			return 1;
+		}
+	}
+	if (check_hexagon(cv::Point2f(200, 300), 90, 33.0f, full_frame) != 0) {
+		std::cout << "Test failed on the full frame" << std::endl;
+		return 1;
+	}
+
+	std::cout << "Test passed !" << std::endl;
+	return 0;
+}
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include <chrono>
+
+#include "reserved_mem.hpp"
+#include "reserved_mem_allocator.hpp"
+
+#define LATENCY_BUFFERS 1000 // Buffers allocated then freed per size
+#define CHURN_STEPS 200000 // Allocations of the fragmentation run
+#define CHURN_REPORT_STEPS 20000
+
+typedef std::chrono::steady_clock bench_clock;
+
+double elapsed_ns(bench_clock::time_point start)
+{
+	return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+}
+
+double percentile(std::vector<double> &values, double p)
+{
+	std::sort(values.begin(), values.end());
+	return values[(size_t)(p * (values.size() - 1))];
+}
+
+// Allocates LATENCY_BUFFERS buffers of size bytes (0: random mix), frees them in random order, prints the latencies
+void latency(ReservedMemAllocator &allocator, uint32_t size, std::mt19937 &random)
+{
+	const uint32_t mix[] = {64, 200, 1500, 4096, 16384, 65536};
+	std::vector<DMABuffer> buffers;
+	std::vector<double> allocate_ns;
+	std::vector<double> free_ns;
+
+	for (int i = 0; i < LATENCY_BUFFERS; i++)
+	{
+		uint32_t length = (size != 0) ? size : mix[random() % (sizeof(mix) / sizeof(mix[0]))];
+		bench_clock::time_point start = bench_clock::now();
+		DMABuffer buffer = allocator.allocate(length);
+		allocate_ns.push_back(elapsed_ns(start));
+		if (!buffer)
+		{
+			break;
+		}
+		buffers.push_back(buffer);
+	}
+	int allocated = buffers.size();
+	std::shuffle(buffers.begin(), buffers.end(), random);
+	for (DMABuffer &buffer : buffers)
+	{
+		bench_clock::time_point start = bench_clock::now();
+		allocator.free(buffer);
+		free_ns.push_back(elapsed_ns(start));
+	}
+
+	char name[16];
+	snprintf(name, sizeof(name), (size != 0) ? "%u" : "mix", size);
+	printf("%10s %10d %12.0f %12.0f %12.0f %12.0f\n", name, allocated,
+		percentile(allocate_ns, 0.5), percentile(allocate_ns, 0.99),
+		percentile(free_ns, 0.5), percentile(free_ns, 0.99));
+}
+
+struct pipeline
+{
+	const char *name;
+	uint32_t buffer_size;
+	unsigned int in_flight; // Buffers kept allocated, the oldest is freed for each new one
+	std::deque<DMABuffer> buffers;
+};
+
+// Pipelines of the project sharing the reserved memory, each recycling its oldest buffer at random steps
+void fragmentation(ReservedMemAllocator &allocator, std::mt19937 &random)
+{
+	pipeline pipelines[] = {
+		{"frames", 640 * 480 * 2, 4, {}},     // YUYV camera frames
+		{"crops", 64 * 64 * 4, 16, {}},       // Bolt crops
+		{"nn inputs", 1000 * 4, 32, {}},      // Float inputs of the NN
+		{"results", 64, 64, {}},              // NN outputs
+		{"bursts", 0, 8, {}},                 // Random sizes up to 256 KiB
+	};
+	const int pipeline_count = sizeof(pipelines) / sizeof(pipelines[0]);
+	int failures = 0;
+
+	printf("\n%10s %12s %14s %14s %14s %10s\n", "step", "buffers", "free [KiB]", "largest [KiB]", "fragmentation",
+		"failures");
+	for (int step = 1; step <= CHURN_STEPS; step++)
+	{
+		pipeline &p = pipelines[random() % pipeline_count];
+		if (p.buffers.size() >= p.in_flight)
+		{
+			allocator.free(p.buffers.front());
+			p.buffers.pop_front();
+		}
+		uint32_t size = (p.buffer_size != 0) ? p.buffer_size : 1 + random() % (256 * 1024);
+		DMABuffer buffer = allocator.allocate(size);
+		if (buffer)
+		{
+			p.buffers.push_back(buffer);
+		}
+		else
+		{
+			failures++;
+		}
+
+		if (step % CHURN_REPORT_STEPS == 0)
+		{
+			ReservedMemAllocator::Stats stats = allocator.stats();
+			printf("%10d %12u %14u %14u %13.1f%% %10d\n", step, stats.allocated_buffers, stats.free_bytes / 1024,
+				stats.largest_free_block / 1024, 100. * stats.fragmentation, failures);
+		}
+	}
+
+	for (pipeline &p : pipelines)
+	{
+		for (DMABuffer &buffer : p.buffers)
+		{
+			allocator.free(buffer);
+		}
+	}
+	ReservedMemAllocator::Stats stats = allocator.stats();
+	printf("Everything freed: %u KiB free, largest block %u KiB\n", stats.free_bytes / 1024,
+		stats.largest_free_block / 1024);
+}
+
+/**
+ * Benchmark of the reserved memory allocator
+ *
+ * - allocation and free latency percentiles (ns) per buffer size, with size class (up to 2048 bytes) and buddy
+ *   allocations, buffers freed in random order
+ * - fragmentation of the reserved memory under the churn of several pipelines keeping buffers in flight
+ *
+ * Runs on the reserved memory when the LKM is loaded (see test_dma.cpp), otherwise on a heap region of the same
+ * size, the allocator only touches its own bookkeeping. Build with:
+ * ```
+ * g++ -O2 -std=c++11 -Ilib bench_allocator.cpp -o bench_allocator
+ * ```
+ */
+int main()
+{
+	Reserved_Mem pmem;
+	uint8_t *region = pmem.data<uint8_t>();
+	uint8_t *heap = nullptr;
+	if (region == nullptr)
+	{
+		printf("%s could not be mapped, running on the heap\n", DEVICE_FILENAME);
+		heap = (uint8_t *)aligned_alloc(ALLOCATOR_PAGE_SIZE, MAX_LENGTH);
+		region = heap;
+	}
+	ReservedMemAllocator allocator(region, pmem.physical_address(), 0, MAX_LENGTH);
+	std::mt19937 random(1);
+
+	printf("%10s %10s %12s %12s %12s %12s\n", "size", "buffers", "alloc p50", "alloc p99", "free p50", "free p99");
+	const uint32_t sizes[] = {64, 256, 2048, 4096, 65536, 1 << 20, 0};
+	for (uint32_t size : sizes)
+	{
+		latency(allocator, size, random);
+	}
+
+	fragmentation(allocator, random);
+
+	free(heap);
+
+	return 0;
+}
@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <chrono>
+
+#include "axi_dma_controller.h"
+#include "axi_dma_sim.hpp"
+#include "reserved_mem.hpp"
+
+#define I_OFFSET 0 // Offset in the reserved memory of the input data (in bytes)
+#define O_OFFSET (MAX_LENGTH / 2) // Offset in the reserved memory of the output data (in bytes)
+#define MIN_SIZE 16 // Bytes
+#define DEFAULT_MAX_SIZE (1 << 22)
+#define DEFAULT_REPETITIONS 100
+#define WAIT_TIMEOUT_MS 1000
+
+#define UIO_DMA_N 0
+
+typedef std::chrono::steady_clock bench_clock;
+
+// DMA path measured by the benchmark: one loop back transfer (MM2S -> S2MM) from input() to output()
+// split in three phases, timed separately
+class Backend
+{
+public:
+	virtual ~Backend() {}
+	virtual const char *name() = 0;
+	virtual uint8_t *input() = 0;
+	virtual uint8_t *output() = 0;
+	// Setup: addresses, S2MM length, everything but the start of MM2S
+	virtual void setup(uint32_t length) = 0;
+	// Transfer: start of MM2S until it has read the input
+	virtual bool transfer(uint32_t length) = 0;
+	// Completion: until S2MM has written the output, with the acknowledgment
+	virtual bool complete() = 0;
+};
+
+// AXI DMA and reserved memory of the board, or their software stand-in
+class DMABackend : public Backend
+{
+public:
+	// sim: simulator to run on (no board needed), the board if nullptr
+	DMABackend(bool use_interrupts, AXIDMASim *sim) : use_interrupts(use_interrupts), simulated(sim != nullptr)
+	{
+		if (simulated)
+		{
+			pmem.reset(new Reserved_Mem(sim->memoryFileDescriptor()));
+			dma.reset(new AXIDMAController(sim->registers(), sim->writeHook(), sim->interruptFileDescriptor()));
+		}
+		else
+		{
+			pmem.reset(new Reserved_Mem());
+			dma.reset(new AXIDMAController(UIO_DMA_N, 0x10000));
+		}
+
+		in = pmem->data<uint8_t>(I_OFFSET);
+		out = pmem->data<uint8_t>(O_OFFSET);
+		if (in == nullptr || out == nullptr)
+		{
+			throw std::string("Reserved memory could not be mapped");
+		}
+
+		dma->MM2SReset();
+		dma->S2MMReset();
+
+		dma->MM2SHalt();
+		dma->S2MMHalt();
+
+		dma->MM2SInterruptEnable();
+		dma->S2MMInterruptEnable();
+
+		dma->MM2SStart();
+		dma->S2MMStart();
+	}
+
+	const char *name()
+	{
+		if (simulated)
+		{
+			return use_interrupts ? "DMA simulator (interrupts)" : "DMA simulator (spin)";
+		}
+		return use_interrupts ? "DMA (interrupts)" : "DMA (spin)";
+	}
+	uint8_t *input() { return in; }
+	uint8_t *output() { return out; }
+
+	void setup(uint32_t length)
+	{
+		dma->S2MMSetDestinationAddress(pmem->physical_address(O_OFFSET));
+		dma->S2MMSetLength(length);
+		dma->MM2SSetSourceAddress(pmem->physical_address(I_OFFSET));
+	}
+
+	bool transfer(uint32_t length)
+	{
+		dma->MM2SSetLength(length);
+		return wait(true);
+	}
+
+	bool complete()
+	{
+		return wait(false);
+	}
+
+private:
+	std::unique_ptr<Reserved_Mem> pmem;
+	std::unique_ptr<AXIDMAController> dma;
+	bool use_interrupts;
+	bool simulated;
+	uint8_t *in;
+	uint8_t *out;
+
+	bool wait(bool mm2s)
+	{
+		uint32_t flags;
+		if (use_interrupts)
+		{
+			flags = mm2s ? dma->MM2SWaitForCompletion(WAIT_TIMEOUT_MS) : dma->S2MMWaitForCompletion(WAIT_TIMEOUT_MS);
+		}
+		else
+		{
+			while ((flags = (mm2s ? dma->MM2SAcknowledgeInterrupts() : dma->S2MMAcknowledgeInterrupts())) == 0) {}
+		}
+		return (flags & STATUS_IOC_IRQ) && !(flags & STATUS_ERR_IRQ);
+	}
+};
+
+double elapsed_us(bench_clock::time_point start, bench_clock::time_point end)
+{
+	return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+double percentile(std::vector<double> &values, double p)
+{
+	std::sort(values.begin(), values.end());
+	return values[(size_t)(p * (values.size() - 1))];
+}
+
+void usage(const char *program)
+{
+	printf("Usage: %s [-s] [-b MB/s] [-l us] [-i] [-n repetitions] [-m max_size] [-c report.csv]\n"
+		"  -s  DMA simulator instead of the board (see axi_dma_sim.hpp)\n"
+		"  -b  bandwidth of the simulated stream in MB/s (default: no limit)\n"
+		"  -l  latency of each simulated transfer in us (default 0)\n"
+		"  -i  wait for the DMA on the interrupt instead of spinning\n"
+		"  -n  transfers per size (default %d)\n"
+		"  -m  largest transfer in bytes (default %d, sizes double from %d)\n"
+		"  -c  also write the results as CSV\n", program, DEFAULT_REPETITIONS, DEFAULT_MAX_SIZE, MIN_SIZE);
+}
+
+/**
+ * DMA throughput and latency benchmark, the baseline of the DMA path optimizations
+ *
+ * For transfer sizes doubling from 16 bytes to 4 MiB, runs the loop back transfer many times and reports the
+ * percentiles of each phase (setup, transfer, completion, in us), and the throughput at the median total time.
+ * Every size is checked (output equal to the input).
+ *
+ * On the board, needs the LKM to be loaded (see test_dma.cpp). Build with `make`, run with `make bench` or
+ * `make bench-sim` without the board (DMA simulator, e.g. `-s -b 1200 -l 5` for a stream close to the board).
+ */
+int main(int argc, char **argv)
+{
+	bool software = false;
+	double bandwidth_mb_s = 0;
+	double latency_us = 0;
+	bool use_interrupts = false;
+	int repetitions = DEFAULT_REPETITIONS;
+	uint32_t max_size = DEFAULT_MAX_SIZE;
+	const char *csv_filename = nullptr;
+
+	int option;
+	while ((option = getopt(argc, argv, "sb:l:in:m:c:h")) != -1)
+	{
+		switch (option)
+		{
+		case 's':
+			software = true;
+			break;
+		case 'b':
+			bandwidth_mb_s = atof(optarg);
+			break;
+		case 'l':
+			latency_us = atof(optarg);
+			break;
+		case 'i':
+			use_interrupts = true;
+			break;
+		case 'n':
+			repetitions = atoi(optarg);
+			break;
+		case 'm':
+			max_size = strtoul(optarg, nullptr, 0);
+			break;
+		case 'c':
+			csv_filename = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return (option == 'h') ? 0 : -1;
+		}
+	}
+	if (repetitions <= 0 || max_size < MIN_SIZE || max_size > MAX_LENGTH / 2 || max_size > DMA_MAX_TRANSFER_LENGTH)
+	{
+		usage(argv[0]);
+		return -1;
+	}
+
+	std::unique_ptr<AXIDMASim> sim; // Outlives the backend
+	std::unique_ptr<Backend> backend;
+	try
+	{
+		if (software)
+		{
+			sim.reset(new AXIDMASim(false, bandwidth_mb_s, latency_us));
+		}
+		backend.reset(new DMABackend(use_interrupts, sim.get()));
+	}
+	catch (const std::string &error)
+	{
+		printf("%s, run with -s to use the DMA simulator\n", error.c_str());
+		return -1;
+	}
+
+	FILE *csv = nullptr;
+	if (csv_filename != nullptr)
+	{
+		csv = fopen(csv_filename, "w");
+		if (csv == nullptr)
+		{
+			printf("Could not open %s\n", csv_filename);
+			return -1;
+		}
+		fprintf(csv, "backend,size,repetitions,setup_p50_us,setup_p99_us,transfer_p50_us,transfer_p99_us,"
+			"completion_p50_us,completion_p99_us,total_p50_us,total_p99_us,mb_per_s\n");
+	}
+
+	printf("%s, %d transfers per size\n", backend->name(), repetitions);
+	printf("%10s %16s %16s %16s %16s %10s\n", "size", "setup p50/p99", "transfer p50/p99", "complete p50/p99",
+		"total p50/p99", "MB/s");
+
+	uint32_t *words = (uint32_t *)backend->input();
+	for (uint32_t i = 0; i < max_size / sizeof(uint32_t); i++)
+	{
+		words[i] = i;
+	}
+
+	for (uint32_t size = MIN_SIZE; size <= max_size; size *= 2)
+	{
+		std::vector<double> setup_us;
+		std::vector<double> transfer_us;
+		std::vector<double> complete_us;
+		std::vector<double> total_us;
+
+		for (int r = 0; r < repetitions; r++)
+		{
+			memset(backend->output(), 0, sizeof(uint32_t));
+			bench_clock::time_point t0 = bench_clock::now();
+			backend->setup(size);
+			bench_clock::time_point t1 = bench_clock::now();
+			bool ok = backend->transfer(size);
+			bench_clock::time_point t2 = bench_clock::now();
+			ok = ok && backend->complete();
+			bench_clock::time_point t3 = bench_clock::now();
+			if (!ok)
+			{
+				printf("Transfer of %u bytes failed\n", size);
+				return -1;
+			}
+
+			setup_us.push_back(elapsed_us(t0, t1));
+			transfer_us.push_back(elapsed_us(t1, t2));
+			complete_us.push_back(elapsed_us(t2, t3));
+			total_us.push_back(elapsed_us(t0, t3));
+		}
+		if (memcmp(backend->input(), backend->output(), size) != 0)
+		{
+			printf("Output of %u bytes differs from the input\n", size);
+			return -1;
+		}
+
+		double total_p50 = percentile(total_us, 0.5);
+		double mb_per_s = size / total_p50; // Bytes per us
+		printf("%10u %7.1f/%-8.1f %7.1f/%-8.1f %7.1f/%-8.1f %7.1f/%-8.1f %10.1f\n", size,
+			percentile(setup_us, 0.5), percentile(setup_us, 0.99),
+			percentile(transfer_us, 0.5), percentile(transfer_us, 0.99),
+			percentile(complete_us, 0.5), percentile(complete_us, 0.99),
+			total_p50, percentile(total_us, 0.99), mb_per_s);
+		if (csv != nullptr)
+		{
+			fprintf(csv, "%s,%u,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", backend->name(), size, repetitions,
+				percentile(setup_us, 0.5), percentile(setup_us, 0.99),
+				percentile(transfer_us, 0.5), percentile(transfer_us, 0.99),
+				percentile(complete_us, 0.5), percentile(complete_us, 0.99),
+				total_p50, percentile(total_us, 0.99), mb_per_s);
+		}
+	}
+
+	if (csv != nullptr)
+	{
+		fclose(csv);
+	}
+
+	return 0;
+}
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+#include <chrono>
+
+#include "axi_dma_controller.h"
+#include "reserved_mem.hpp"
+
+#define I_OFFSET 0 // Offset in the reserved memory of the input data (in bytes)
+#define O_OFFSET (MAX_LENGTH / 2) // Offset in the reserved memory of the output data (in bytes)
+#define REPETITIONS 200
+#define WAIT_TIMEOUT_MS 1000
+
+#define UIO_DMA_N 0
+
+enum wait_mode { WAIT_SPIN, WAIT_INTERRUPT };
+
+double thread_cpu_s()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+double percentile(std::vector<double> &values, double p)
+{
+	std::sort(values.begin(), values.end());
+	return values[(size_t)(p * (values.size() - 1))];
+}
+
+// Runs REPETITIONS loop back transfers of length bytes, waiting for each one with the given mode
+// Prints the completion latency percentiles and the CPU time used by the wait
+bool run(AXIDMAController &dma, Reserved_Mem &pmem, int length, wait_mode mode)
+{
+	std::vector<double> latencies_us;
+	double cpu_s = 0;
+	double wall_s = 0;
+
+	for (int r = 0; r < REPETITIONS; r++)
+	{
+		dma.MM2SSetSourceAddress(pmem.physical_address(I_OFFSET));
+		dma.S2MMSetDestinationAddress(pmem.physical_address(O_OFFSET));
+		dma.S2MMSetLength(length);
+
+		double cpu_start = thread_cpu_s();
+		auto start = std::chrono::steady_clock::now();
+		dma.MM2SSetLength(length);
+
+		if (mode == WAIT_SPIN)
+		{
+			// Spin loop of test_dma.cpp, on the IOC bits so that an idle channel between two transfers does not count
+			while ((dma.MM2SAcknowledgeInterrupts() & STATUS_IOC_IRQ) == 0) {}
+			while ((dma.S2MMAcknowledgeInterrupts() & STATUS_IOC_IRQ) == 0) {}
+		}
+		else
+		{
+			// MM2S first: with both channel interrupts ORed on the UIO device its pending IOC would keep the line up
+			if ((dma.MM2SWaitForCompletion(WAIT_TIMEOUT_MS) & STATUS_IOC_IRQ) == 0 ||
+				(dma.S2MMWaitForCompletion(WAIT_TIMEOUT_MS) & STATUS_IOC_IRQ) == 0)
+			{
+				printf("No completion interrupt for %d bytes\n", length);
+				return false;
+			}
+		}
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		cpu_s += thread_cpu_s() - cpu_start;
+		wall_s += elapsed.count();
+		latencies_us.push_back(elapsed.count() * 1e6);
+	}
+
+	printf("%10d %10s %10.1f %10.1f %10.1f %10.1f %9.1f%%\n", length, (mode == WAIT_SPIN) ? "spin" : "interrupt",
+		percentile(latencies_us, 0.5), percentile(latencies_us, 0.9), percentile(latencies_us, 0.99),
+		latencies_us.back(), 100. * cpu_s / wall_s);
+	return true;
+}
+
+/**
+ * Benchmark of the DMA completion waits
+ *
+ * For transfer sizes from 64 bytes to 4 MiB (MM2S looped back to S2MM), compares the spin loop on the status
+ * registers with the blocking wait on the UIO interrupt: completion latency percentiles (from the start of
+ * MM2S to the end of the wait) and the share of that time the waiting thread spent on the CPU.
+ *
+ * The UIO device of the DMA must have its interrupt (the S2MM one, or both channels ORed), and the LKM must be
+ * loaded (see test_dma.cpp). Build with:
+ * ```
+ * g++ -O2 -std=c++11 -Ilib bench_dma_wait.cpp -o bench_dma_wait
+ * ```
+ */
+int main()
+{
+	Reserved_Mem pmem;
+	AXIDMAController dma(UIO_DMA_N, 0x10000);
+
+	uint8_t *i_buff = pmem.data<uint8_t>(I_OFFSET);
+	if (i_buff == nullptr)
+	{
+		printf("Could not map %s\n", DEVICE_FILENAME);
+		return -1;
+	}
+	memset(i_buff, 0x5A, O_OFFSET - I_OFFSET);
+
+	dma.MM2SReset();
+	dma.S2MMReset();
+
+	dma.MM2SHalt();
+	dma.S2MMHalt();
+
+	dma.MM2SInterruptEnable();
+	dma.S2MMInterruptEnable();
+
+	dma.MM2SStart();
+	dma.S2MMStart();
+
+	printf("%10s %10s %10s %10s %10s %10s %10s\n", "length", "wait", "p50 [us]", "p90 [us]", "p99 [us]", "max [us]",
+		"CPU");
+
+	for (int length = 64; length <= (1 << 22); length *= 4)
+	{
+		if (!run(dma, pmem, length, WAIT_SPIN) || !run(dma, pmem, length, WAIT_INTERRUPT))
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
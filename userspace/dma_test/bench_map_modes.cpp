@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+
+#include <chrono>
+
+#include "reserved_mem.hpp"
+
+#define MIN_LENGTH 0x1000 // Bytes
+#define MAX_BENCH_LENGTH (MAX_LENGTH / 2) // Bytes
+#define BYTES_PER_SIZE (32 * 1024 * 1024) // Bytes moved for each size, mode and access
+#define MIN_REPETITIONS 4
+
+typedef std::chrono::steady_clock bench_clock;
+
+double elapsed_s(bench_clock::time_point start)
+{
+	return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+double mb_per_s(int length, int repetitions, double seconds)
+{
+	return (double)length * repetitions / 1000000. / seconds;
+}
+
+struct map_mode
+{
+	const char *name;
+	int mode;
+};
+
+/**
+ * Benchmark of the memory types of the reserved memory mappings
+ *
+ * For buffer sizes from 4 KiB to 8 MiB and for each mapping mode (uncached, write combining, cached), measures:
+ *  - fill: the CPU writes the payload word by word, as a preprocessing step would before MM2S
+ *  - memcpy in: a user buffer is copied in
+ *  - read: the CPU sums the buffer, as a consumer would after S2MM
+ * The cached mode includes the cache maintenance the DMA needs: sync_for_device() after fill / memcpy in,
+ * sync_for_cpu() before read. Each mode is mapped alone, for its runs only.
+ *
+ * Needs the LKM to be loaded (see test_dma.cpp), build with:
+ * ```
+ * g++ -O2 -std=c++11 -Ilib bench_map_modes.cpp -o bench_map_modes
+ * ```
+ */
+int main()
+{
+	Reserved_Mem pmem;
+
+	map_mode modes[] = {
+		{"uncached", RESERVEDMEM_MAP_UNCACHED},
+		{"write comb.", RESERVEDMEM_MAP_WRITECOMBINE},
+		{"cached", RESERVEDMEM_MAP_CACHED},
+	};
+
+	uint32_t *u_buff = (uint32_t *)malloc(MAX_BENCH_LENGTH);
+	if (u_buff == NULL)
+	{
+		printf("Could not allocate user buffer\n");
+		return -1;
+	}
+	memset(u_buff, 0x5A, MAX_BENCH_LENGTH);
+
+	printf("%10s %12s %12s %12s %12s  [MB/s]\n", "length", "mode", "fill", "memcpy in", "read");
+
+	for (int length = MIN_LENGTH; length <= MAX_BENCH_LENGTH; length *= 2)
+	{
+		int words = length / sizeof(uint32_t);
+		int repetitions = BYTES_PER_SIZE / length;
+		if (repetitions < MIN_REPETITIONS)
+		{
+			repetitions = MIN_REPETITIONS;
+		}
+
+		for (map_mode &m : modes)
+		{
+			// One mode mapped at a time: on ARM, mappings of the same memory with different memory types are
+			// mismatched aliases, the cached one would break the coherency of the others
+			bool cached = m.mode == RESERVEDMEM_MAP_CACHED;
+			uint32_t *buffer = pmem.map_buffer<uint32_t>(0, MAX_BENCH_LENGTH, m.mode);
+			if (buffer == nullptr)
+			{
+				printf("Could not map %s as %s: %s\n", DEVICE_FILENAME, m.name, strerror(errno));
+				return -1;
+			}
+
+			bench_clock::time_point start = bench_clock::now();
+			for (int r = 0; r < repetitions; r++)
+			{
+				for (int i = 0; i < words; i++)
+				{
+					buffer[i] = i + r;
+				}
+				if (cached)
+				{
+					pmem.sync_for_device(0, length);
+				}
+			}
+			double fill_s = elapsed_s(start);
+
+			start = bench_clock::now();
+			for (int r = 0; r < repetitions; r++)
+			{
+				memcpy(buffer, u_buff, length);
+				if (cached)
+				{
+					pmem.sync_for_device(0, length);
+				}
+			}
+			double memcpy_in_s = elapsed_s(start);
+
+			volatile uint32_t sum = 0;
+			start = bench_clock::now();
+			for (int r = 0; r < repetitions; r++)
+			{
+				if (cached)
+				{
+					pmem.sync_for_cpu(0, length);
+				}
+				uint32_t s = 0;
+				for (int i = 0; i < words; i++)
+				{
+					s += buffer[i];
+				}
+				sum = sum + s;
+			}
+			double read_s = elapsed_s(start);
+
+			if (cached)
+			{
+				pmem.sync_for_cpu(0, MAX_BENCH_LENGTH); // No line of the cached mapping left behind
+			}
+			pmem.unmap_buffer(buffer);
+
+			printf("%10d %12s %12.1f %12.1f %12.1f\n", length, m.name,
+				mb_per_s(length, repetitions, fill_s),
+				mb_per_s(length, repetitions, memcpy_in_s),
+				mb_per_s(length, repetitions, read_s));
+		}
+	}
+
+	free(u_buff);
+
+	return 0;
+}
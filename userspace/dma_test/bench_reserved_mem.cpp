@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+
+#include <chrono>
+
+#include "reserved_mem.hpp"
+
+#define MIN_LENGTH 0x1000 // Bytes
+#define MAX_BENCH_LENGTH (MAX_LENGTH / 2) // Bytes
+#define BYTES_PER_SIZE (64 * 1024 * 1024) // Bytes moved for each size and each path
+#define MIN_REPETITIONS 4
+
+typedef std::chrono::steady_clock bench_clock;
+
+double elapsed_s(bench_clock::time_point start)
+{
+	return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+double mb_per_s(int length, int repetitions, double seconds)
+{
+	return (double)length * repetitions / 1000000. / seconds;
+}
+
+/**
+ * Benchmark of the reserved memory access paths
+ *
+ * Compares, for buffer sizes from 4 KiB to 8 MiB, the copy path of Reserved_Mem (write()/read() of the LKM
+ * copying through the kernel) with the direct mapping of the reserved memory (Reserved_Mem::data()):
+ *  - transfer / gather: user buffer to reserved memory and back through the LKM
+ *  - memcpy in / out: same copies done in user space through the mapping
+ *  - fill in place: the producer writes the payload directly in the reserved memory, no copy at all,
+ *    against filling a user buffer then transfer()
+ *
+ * Needs the LKM to be loaded (see test_dma.cpp), build with:
+ * ```
+ * g++ -O2 -std=c++11 -Ilib bench_reserved_mem.cpp -o bench_reserved_mem
+ * ```
+ */
+int main()
+{
+	Reserved_Mem pmem;
+
+	uint32_t *mapped = pmem.data<uint32_t>();
+	if (mapped == nullptr)
+	{
+		printf("Could not map %s, is the LKM loaded ?\n", DEVICE_FILENAME);
+		return -1;
+	}
+
+	uint32_t *u_buff = (uint32_t *)malloc(MAX_BENCH_LENGTH);
+	if (u_buff == NULL)
+	{
+		printf("Could not allocate user buffer\n");
+		return -1;
+	}
+	memset(u_buff, 0x5A, MAX_BENCH_LENGTH);
+
+	printf("%10s %12s %12s %12s %12s %14s %14s  [MB/s]\n",
+		"length", "transfer", "memcpy in", "gather", "memcpy out", "fill+transfer", "fill in place");
+
+	for (int length = MIN_LENGTH; length <= MAX_BENCH_LENGTH; length *= 2)
+	{
+		int words = length / sizeof(uint32_t);
+		int repetitions = BYTES_PER_SIZE / length;
+		if (repetitions < MIN_REPETITIONS)
+		{
+			repetitions = MIN_REPETITIONS;
+		}
+
+		bench_clock::time_point start = bench_clock::now();
+		for (int r = 0; r < repetitions; r++)
+		{
+			if ((int)pmem.transfer(u_buff, 0, length) < 0)
+			{
+				printf("transfer of %d bytes failed: %s\n", length, strerror(errno));
+				return -1;
+			}
+		}
+		double transfer_s = elapsed_s(start);
+
+		start = bench_clock::now();
+		for (int r = 0; r < repetitions; r++)
+		{
+			memcpy(mapped, u_buff, length);
+		}
+		double memcpy_in_s = elapsed_s(start);
+
+		start = bench_clock::now();
+		for (int r = 0; r < repetitions; r++)
+		{
+			if ((int)pmem.gather(u_buff, 0, length) < 0)
+			{
+				printf("gather of %d bytes failed: %s\n", length, strerror(errno));
+				return -1;
+			}
+		}
+		double gather_s = elapsed_s(start);
+
+		start = bench_clock::now();
+		for (int r = 0; r < repetitions; r++)
+		{
+			memcpy(u_buff, mapped, length);
+		}
+		double memcpy_out_s = elapsed_s(start);
+
+		start = bench_clock::now();
+		for (int r = 0; r < repetitions; r++)
+		{
+			for (int i = 0; i < words; i++)
+			{
+				u_buff[i] = i + r;
+			}
+			pmem.transfer(u_buff, 0, length);
+		}
+		double fill_transfer_s = elapsed_s(start);
+
+		// The mapping must see what the copy path wrote
+		int last = repetitions - 1;
+		if (mapped[0] != (uint32_t)last || mapped[words - 1] != (uint32_t)(words - 1 + last))
+		{
+			printf("Mapped memory does not match the transferred data at %d bytes\n", length);
+			return -1;
+		}
+
+		start = bench_clock::now();
+		for (int r = 0; r < repetitions; r++)
+		{
+			for (int i = 0; i < words; i++)
+			{
+				mapped[i] = i + r;
+			}
+		}
+		double fill_in_place_s = elapsed_s(start);
+
+		printf("%10d %12.1f %12.1f %12.1f %12.1f %14.1f %14.1f\n", length,
+			mb_per_s(length, repetitions, transfer_s),
+			mb_per_s(length, repetitions, memcpy_in_s),
+			mb_per_s(length, repetitions, gather_s),
+			mb_per_s(length, repetitions, memcpy_out_s),
+			mb_per_s(length, repetitions, fill_transfer_s),
+			mb_per_s(length, repetitions, fill_in_place_s));
+	}
+
+	free(u_buff);
+
+	return 0;
+}
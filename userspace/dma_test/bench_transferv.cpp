@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <chrono>
+
+#include "reserved_mem.hpp"
+
+#define SEGMENTS 64 // Segments per batch
+#define MIN_SEGMENT_LENGTH 64 // Bytes
+#define MAX_SEGMENT_LENGTH 0x10000 // Bytes
+#define BYTES_PER_SIZE (16 * 1024 * 1024) // Bytes moved for each size and each path
+#define THREADS 4
+
+typedef std::chrono::steady_clock bench_clock;
+
+double elapsed_s(bench_clock::time_point start)
+{
+	return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// Segments of length bytes, the i-th one between buffer + i * length and the reserved memory at
+// offset + i * length
+std::vector<struct reservedmem_segment> make_batch(uint8_t *buffer, uint32_t offset, uint32_t length, uint32_t direction)
+{
+	std::vector<struct reservedmem_segment> batch;
+	for (int i = 0; i < SEGMENTS; i++)
+	{
+		batch.push_back(Reserved_Mem::segment(buffer + i * length, offset + i * length, length, direction));
+	}
+	return batch;
+}
+
+/**
+ * Benchmark of the batched copies of the LKM (Reserved_Mem::transferv)
+ *
+ * For segments of 64 bytes to 64 KiB, copies batches of SEGMENTS segments to the reserved memory and back:
+ *  - one transfer() / gather() per segment (one write() / read() syscall each)
+ *  - one transferv() per batch (one ioctl for the SEGMENTS segments)
+ *  - one transferv() per batch from THREADS threads at once on separate regions, they wait for each other in
+ *    the LKM instead of failing
+ * Prints the segments per second and checks the gathered data.
+ *
+ * Needs the LKM to be loaded (see test_dma.cpp), build with `make`.
+ */
+int main()
+{
+	Reserved_Mem pmem;
+	if (pmem.data<uint8_t>() == nullptr)
+	{
+		printf("Could not map %s, is the LKM loaded ?\n", DEVICE_FILENAME);
+		return -1;
+	}
+
+	uint32_t batch_length = SEGMENTS * MAX_SEGMENT_LENGTH;
+	std::vector<uint8_t> in(THREADS * batch_length);
+	std::vector<uint8_t> out(THREADS * batch_length);
+	for (size_t i = 0; i < in.size(); i++)
+	{
+		in[i] = (uint8_t)(i * 7);
+	}
+
+	printf("%10s %16s %16s %16s  [segments/s]\n", "segment", "transfer/gather", "transferv", "transferv x4");
+
+	for (uint32_t length = MIN_SEGMENT_LENGTH; length <= MAX_SEGMENT_LENGTH; length *= 4)
+	{
+		int repetitions = BYTES_PER_SIZE / (SEGMENTS * length);
+		if (repetitions < 1)
+		{
+			repetitions = 1;
+		}
+
+		bench_clock::time_point start = bench_clock::now();
+		for (int r = 0; r < repetitions; r++)
+		{
+			for (int i = 0; i < SEGMENTS; i++)
+			{
+				// transfer / gather take the offset in 32-bit words
+				if ((int)pmem.transfer(&in[i * length], i * length / sizeof(uint32_t), length) < 0 ||
+					(int)pmem.gather(&out[i * length], i * length / sizeof(uint32_t), length) < 0)
+				{
+					printf("transfer / gather of %u bytes failed: %s\n", length, strerror(errno));
+					return -1;
+				}
+			}
+		}
+		double single_s = elapsed_s(start);
+
+		std::vector<struct reservedmem_segment> to_device = make_batch(in.data(), 0, length, RESERVEDMEM_TO_DEVICE);
+		std::vector<struct reservedmem_segment> from_device = make_batch(out.data(), 0, length, RESERVEDMEM_FROM_DEVICE);
+		memset(out.data(), 0, SEGMENTS * length);
+		start = bench_clock::now();
+		for (int r = 0; r < repetitions; r++)
+		{
+			if (pmem.transferv(to_device.data(), SEGMENTS) != SEGMENTS ||
+				pmem.transferv(from_device.data(), SEGMENTS) != SEGMENTS)
+			{
+				printf("transferv of %u bytes segments failed: %s\n", length, strerror(errno));
+				return -1;
+			}
+		}
+		double batched_s = elapsed_s(start);
+		if (memcmp(in.data(), out.data(), SEGMENTS * length) != 0)
+		{
+			printf("Gathered data differs at %u bytes segments\n", length);
+			return -1;
+		}
+
+		// Each thread has its own region of the reserved memory and of the user buffers
+		int failures = 0;
+		std::vector<std::thread> threads;
+		memset(out.data(), 0, out.size());
+		start = bench_clock::now();
+		for (int t = 0; t < THREADS; t++)
+		{
+			threads.emplace_back([&, t]()
+			{
+				uint32_t offset = t * batch_length;
+				std::vector<struct reservedmem_segment> to = make_batch(&in[offset], offset, length, RESERVEDMEM_TO_DEVICE);
+				std::vector<struct reservedmem_segment> from = make_batch(&out[offset], offset, length, RESERVEDMEM_FROM_DEVICE);
+				for (int r = 0; r < repetitions; r++)
+				{
+					if (pmem.transferv(to.data(), SEGMENTS) != SEGMENTS || pmem.transferv(from.data(), SEGMENTS) != SEGMENTS)
+					{
+						__sync_fetch_and_add(&failures, 1);
+						return;
+					}
+				}
+			});
+		}
+		for (std::thread &thread : threads)
+		{
+			thread.join();
+		}
+		double threaded_s = elapsed_s(start);
+		for (int t = 0; t < THREADS; t++)
+		{
+			if (memcmp(&in[t * batch_length], &out[t * batch_length], SEGMENTS * length) != 0)
+			{
+				failures++;
+			}
+		}
+		if (failures != 0)
+		{
+			printf("%d thread(s) failed at %u bytes segments\n", failures, length);
+			return -1;
+		}
+
+		double segments = 2. * SEGMENTS * repetitions;
+		printf("%10u %16.0f %16.0f %16.0f\n", length, segments / single_s, segments / batched_s,
+			THREADS * segments / threaded_s);
+	}
+
+	return 0;
+}
@@ -10,21 +10,31 @@
 #include <sys/mman.h>
 #include <unistd.h>
 #include <stddef.h>
+#include <poll.h>
 
+#include <functional>
 #include <string>
 #include <sstream>
 #include <vector>
 
 #define MM2S_CONTROL_REGISTER       0x00
 #define MM2S_STATUS_REGISTER        0x04
+#define MM2S_CURDESC_REGISTER       0x08
+#define MM2S_TAILDESC_REGISTER      0x10
 #define MM2S_SRC_ADDRESS_REGISTER   0x18
 #define MM2S_TRNSFR_LENGTH_REGISTER 0x28
 
 #define S2MM_CONTROL_REGISTER       0x30
 #define S2MM_STATUS_REGISTER        0x34
+#define S2MM_CURDESC_REGISTER       0x38
+#define S2MM_TAILDESC_REGISTER      0x40
 #define S2MM_DST_ADDRESS_REGISTER   0x48
 #define S2MM_BUFF_LENGTH_REGISTER   0x58
 
+#define DMA_MAX_TRANSFER_LENGTH     0x007FFFFF // Bytes, default width of the length registers (23 bits)
+#define DMA_LENGTH_REGISTER_MASK    0x03FFFFFF // Widest length registers (26 bits), the other bits are reserved
+#define DMA_RESET_TIMEOUT_POLLS     1000000    // Reads of the control register until the reset bit clears
+
 #define IOC_IRQ_FLAG                1<<12
 #define IDLE_FLAG                   1<<1
 
@@ -48,6 +58,22 @@
 #define ENABLE_DELAY_IRQ            0x00002000
 #define ENABLE_ERR_IRQ              0x00004000
 #define ENABLE_ALL_IRQ              0x00007000
+#define ALL_IRQ_FLAGS               0x00007000 // Status bits, cleared by writing 1
+
+// Scatter gather descriptors
+#define SG_DESCRIPTOR_ALIGNMENT     0x40
+#define SG_MAX_LENGTH               0x03FFFFFF // Buffer length field, the real limit is the buffer length register width
+#define SG_CONTROL_LENGTH_MASK      0x03FFFFFF
+#define SG_CONTROL_EOF              0x04000000 // Last buffer of a packet (MM2S)
+#define SG_CONTROL_SOF              0x08000000 // First buffer of a packet (MM2S)
+#define SG_STATUS_LENGTH_MASK       0x03FFFFFF // Bytes transferred
+#define SG_STATUS_RXEOF             0x04000000 // Last buffer of a packet (S2MM)
+#define SG_STATUS_RXSOF             0x08000000 // First buffer of a packet (S2MM)
+#define SG_STATUS_INTERNAL_ERR      0x10000000
+#define SG_STATUS_SLAVE_ERR         0x20000000
+#define SG_STATUS_DECODE_ERR        0x40000000
+#define SG_STATUS_ERR               0x70000000
+#define SG_STATUS_COMPLETE          0x80000000
 
 enum dma_status {
     DMA_HALTED = 0x00000001,
@@ -152,16 +178,184 @@ public:
     }
 };
 
+// Orders the memory accesses (descriptors, buffers) with the register accesses of the DMA
+inline void dma_barrier() {
+#if defined(__aarch64__)
+    asm volatile("dsb sy" ::: "memory");
+#else
+    __sync_synchronize();
+#endif
+}
+
+// AXI DMA scatter gather descriptor, in memory the DMA can read (reserved memory)
+struct SGDescriptor {
+    uint32_t next_descriptor;
+    uint32_t next_descriptor_msb;
+    uint32_t buffer_address;
+    uint32_t buffer_address_msb;
+    uint32_t reserved[2];
+    uint32_t control;
+    uint32_t status;
+    uint32_t app[5];
+    uint32_t padding[3]; // Up to SG_DESCRIPTOR_ALIGNMENT
+};
+
+// Circular ring of scatter gather descriptors for one channel (MM2S or S2MM)
+// The descriptors live in memory mapped both in user space (descriptors) and for the DMA (physical_address),
+// uncached or write combining, for example Reserved_Mem::data() and Reserved_Mem::physical_address().
+// Buffers are queued with push() and handed to the DMA with AXIDMAController::MM2SStartSG / S2MMStartSG,
+// then MM2SQueueSG / S2MMQueueSG while it runs. pop() returns the completed descriptors in order.
+class SGRing {
+public:
+    // descriptors: room for count descriptors, physical_address aligned on SG_DESCRIPTOR_ALIGNMENT
+    SGRing(void *descriptors, uint32_t physical_address, unsigned int count)
+        : ring((volatile SGDescriptor *)descriptors), ring_address(physical_address), count(count),
+          head(0), tail(0), pending(0) {
+
+        if (physical_address % SG_DESCRIPTOR_ALIGNMENT != 0 || count == 0) {
+            throw std::string("SG ring needs descriptors aligned on 64 bytes");
+        }
+
+        for (unsigned int i = 0; i < count; i++) {
+            ring[i].next_descriptor = descriptorAddress((i + 1) % count);
+            ring[i].next_descriptor_msb = 0;
+            ring[i].buffer_address_msb = 0;
+            ring[i].control = 0;
+            ring[i].status = 0;
+        }
+
+    }
+
+    // Forgets every pushed descriptor, only while the channel is halted or reset
+    void reset() {
+
+        for (unsigned int i = 0; i < count; i++) {
+            ring[i].control = 0;
+            ring[i].status = 0;
+        }
+        head = 0;
+        tail = 0;
+        pending = 0;
+
+    }
+
+    unsigned int size() const {
+
+        return count;
+
+    }
+
+    // Descriptors pushed and not popped yet
+    unsigned int inFlight() const {
+
+        return pending;
+
+    }
+
+    bool full() const {
+
+        return pending == count;
+
+    }
+
+    // Queues a buffer of length bytes (up to the buffer length register width) at the physical address
+    // A packet (TLAST on the stream) ends with end_of_frame, it can span several MM2S buffers
+    // Returns the descriptor index, -1 if the ring is full
+    int push(uint32_t buffer_address, uint32_t length, bool start_of_frame = true, bool end_of_frame = true) {
+
+        if (full() || length == 0 || length > SG_MAX_LENGTH) {
+            return -1;
+        }
+
+        unsigned int index = tail;
+        ring[index].buffer_address = buffer_address;
+        ring[index].control = (length & SG_CONTROL_LENGTH_MASK) |
+                              (start_of_frame ? SG_CONTROL_SOF : 0) |
+                              (end_of_frame ? SG_CONTROL_EOF : 0);
+        ring[index].status = 0; // The DMA stops on a descriptor still marked complete
+        tail = (tail + 1) % count;
+        pending++;
+
+        return index;
+
+    }
+
+    // Oldest pushed descriptor, if the DMA completed it: returns its index and frees it, -1 otherwise
+    // status receives the descriptor status (SG_STATUS_*, transferred bytes in SG_STATUS_LENGTH_MASK)
+    int pop(uint32_t &status) {
+
+        if (pending == 0 || !isComplete(head)) {
+            return -1;
+        }
+        dma_barrier(); // The buffer is read after the completion
+
+        unsigned int index = head;
+        status = ring[index].status;
+        head = (head + 1) % count;
+        pending--;
+
+        return index;
+
+    }
+
+    bool isComplete(unsigned int index) const {
+
+        return (ring[index].status & SG_STATUS_COMPLETE) != 0;
+
+    }
+
+    bool hasError(unsigned int index) const {
+
+        return (ring[index].status & SG_STATUS_ERR) != 0;
+
+    }
+
+    uint32_t transferred(unsigned int index) const {
+
+        return ring[index].status & SG_STATUS_LENGTH_MASK;
+
+    }
+
+    uint32_t descriptorAddress(unsigned int index) const {
+
+        return ring_address + index * sizeof(SGDescriptor);
+
+    }
+
+    // First descriptor the DMA has to process (oldest pushed)
+    uint32_t headAddress() const {
+
+        return descriptorAddress(head);
+
+    }
+
+    // Last descriptor the DMA has to process (newest pushed)
+    uint32_t tailAddress() const {
+
+        return descriptorAddress((tail + count - 1) % count);
+
+    }
+
+private:
+    volatile SGDescriptor *ring;
+    uint32_t ring_address;
+    unsigned int count;
+    unsigned int head;    // Oldest pushed descriptor
+    unsigned int tail;    // Next free descriptor
+    unsigned int pending; // Pushed, not popped
+};
+
 // class named AXIDMAController
 class AXIDMAController {
 public:
+    // Receives the register writes of a register block that is not a device (see AXIDMASim), offset in bytes
+    typedef std::function<void(uint32_t offset, uint32_t value)> RegisterWriteHook;
+
     // Constructor
     AXIDMAController(unsigned int uio_number, unsigned int uio_size) {
         char device_file_name[20];
         sprintf(device_file_name, "/dev/uio%d", uio_number);
 
-        int device_file;
-
         if ((device_file = open(device_file_name, O_RDWR | O_SYNC)) < 0) {
             std::stringstream ss;
             ss << device_file_name << " could not be opened";
@@ -171,17 +365,105 @@ public:
         uio_map = (uint32_t *)mmap(NULL, uio_size, PROT_READ | PROT_WRITE, MAP_SHARED, device_file, 0);
 
         if (uio_map == MAP_FAILED) {
+            close(device_file);
             std::stringstream ss;
             ss << device_file_name << " could not be mapped";
             throw ss.str();
         }
 
+        map_size = uio_size;
+        interrupt_count_size = sizeof(uint32_t);
+
+    }
+
+    // Controller of a register block emulated in software: registers is read directly, the writes go to
+    // write_hook so that the emulation applies their side effects (start, reset, write 1 to clear)
+    // interrupt_fd: eventfd signaled on each interrupt, -1 without interrupts; both stay owned by the caller
+    AXIDMAController(uint32_t *registers, RegisterWriteHook write_hook, int interrupt_fd = -1)
+        : uio_map(registers), device_file(interrupt_fd), map_size(0), interrupt_count_size(sizeof(uint64_t)),
+          write_hook(write_hook) {
+
     }
 
+    AXIDMAController(const AXIDMAController &) = delete;
+    AXIDMAController &operator=(const AXIDMAController &) = delete;
+
     // Destructor
     ~AXIDMAController() {
 
-        munmap(uio_map, 0x1000);
+        if (map_size > 0) {
+            munmap(uio_map, map_size);
+            close(device_file);
+        }
+
+    }
+
+    // UIO file (or eventfd), readable (POLLIN) once the armed interrupt fired, to wait on several devices at once
+    int GetInterruptFileDescriptor() {
+
+        return device_file;
+
+    }
+
+    // Re-enables the interrupt of the UIO device, disabled by the kernel each time it fires
+    bool InterruptArm() {
+
+        if (map_size == 0) {
+            return device_file >= 0; // An eventfd needs no arming
+        }
+        uint32_t enable = 1;
+        return write(device_file, &enable, sizeof(enable)) == sizeof(enable);
+
+    }
+
+    // Blocks until the armed interrupt fires or timeout_ms elapse (-1: no timeout)
+    // Returns false on timeout or error, the interrupt is then disarmed again by InterruptArm()
+    bool InterruptWait(int timeout_ms = -1) {
+
+        struct pollfd fd = {device_file, POLLIN, 0};
+        if (poll(&fd, 1, timeout_ms) <= 0) {
+            return false;
+        }
+
+        uint64_t count = 0; // Interrupts since the opening (UIO, 32 bits) or the last read (eventfd, 64 bits)
+        return read(device_file, &count, interrupt_count_size) == (ssize_t)interrupt_count_size;
+
+    }
+
+    // Clears the interrupt status bits that are set (IOC, delay, error), so that the interrupt line goes down
+    uint32_t MM2SAcknowledgeInterrupts() {
+
+        uint32_t flags = getMM2SStatus() & ALL_IRQ_FLAGS;
+        if (flags != 0) {
+            writeAXI(MM2S_STATUS_REGISTER, flags);
+        }
+        return flags;
+
+    }
+
+    uint32_t S2MMAcknowledgeInterrupts() {
+
+        uint32_t flags = getS2MMStatus() & ALL_IRQ_FLAGS;
+        if (flags != 0) {
+            writeAXI(S2MM_STATUS_REGISTER, flags);
+        }
+        return flags;
+
+    }
+
+    // Blocks on the UIO interrupt until the channel raised IOC (or an error), instead of spinning on MM2SIsSynced
+    // The interrupt of the UIO device must be the one of the channel (or of both channels, ORed), with the
+    // interrupts enabled on the channel (MM2SInterruptEnable)
+    // Returns the acknowledged interrupt flags (STATUS_IOC_IRQ, STATUS_ERR_IRQ...), 0 on timeout
+    uint32_t MM2SWaitForCompletion(int timeout_ms = -1) {
+
+        return waitForCompletion(MM2S_STATUS_REGISTER, timeout_ms);
+
+    }
+
+    uint32_t S2MMWaitForCompletion(int timeout_ms = -1) {
+
+        return waitForCompletion(S2MM_STATUS_REGISTER, timeout_ms);
 
     }
 
@@ -217,39 +499,44 @@ public:
             
     }
 
+    // The reset bit reads 1 until the reset is done, the control register must not be written before
     void MM2SReset() {
 
         writeAXI(MM2S_CONTROL_REGISTER, RESET_DMA);
+        waitReset(MM2S_CONTROL_REGISTER);
 
     }
 
     void S2MMReset() {
 
         writeAXI(S2MM_CONTROL_REGISTER, RESET_DMA);
+        waitReset(S2MM_CONTROL_REGISTER);
 
     }
 
+    // Control register bits are read-modify-written, so halting, enabling the interrupts and starting
+    // keep each other's settings
     void MM2SHalt() {
 
-        writeAXI(MM2S_CONTROL_REGISTER, HALT_DMA);
+        writeAXI(MM2S_CONTROL_REGISTER, readAXI(MM2S_CONTROL_REGISTER) & ~RUN_DMA);
 
     }
 
     void S2MMHalt() {
 
-        writeAXI(S2MM_CONTROL_REGISTER, HALT_DMA);
+        writeAXI(S2MM_CONTROL_REGISTER, readAXI(S2MM_CONTROL_REGISTER) & ~RUN_DMA);
 
     }
 
     void MM2SInterruptEnable() {
 
-        writeAXI(MM2S_CONTROL_REGISTER, ENABLE_ALL_IRQ);
+        writeAXI(MM2S_CONTROL_REGISTER, readAXI(MM2S_CONTROL_REGISTER) | ENABLE_ALL_IRQ);
 
     }
 
     void S2MMInterruptEnable() {
 
-        writeAXI(S2MM_CONTROL_REGISTER, ENABLE_ALL_IRQ);
+        writeAXI(S2MM_CONTROL_REGISTER, readAXI(S2MM_CONTROL_REGISTER) | ENABLE_ALL_IRQ);
 
     }
 
@@ -277,15 +564,92 @@ public:
 
     }
 
+    // Bytes actually received by the last S2MM transfer (simple mode), once it is synced
+    unsigned int S2MMGetLength() {
+
+        return readAXI(S2MM_BUFF_LENGTH_REGISTER) & DMA_LENGTH_REGISTER_MASK;
+
+    }
+
     void MM2SStart() {
 
-        writeAXI(MM2S_CONTROL_REGISTER, RUN_DMA);
+        writeAXI(MM2S_CONTROL_REGISTER, readAXI(MM2S_CONTROL_REGISTER) | RUN_DMA);
 
     }
 
     void S2MMStart() {
 
-        writeAXI(S2MM_CONTROL_REGISTER, RUN_DMA);
+        writeAXI(S2MM_CONTROL_REGISTER, readAXI(S2MM_CONTROL_REGISTER) | RUN_DMA);
+
+    }
+
+    // True if the DMA is built with the scatter gather engine
+    bool IsScatterGather() {
+
+        return (getMM2SStatus() & STATUS_SG_INCLDED) != 0;
+
+    }
+
+    void MM2SSetCurrentDescriptor(uint32_t address) {
+
+        writeAXI(MM2S_CURDESC_REGISTER, address);
+
+    }
+
+    void S2MMSetCurrentDescriptor(uint32_t address) {
+
+        writeAXI(S2MM_CURDESC_REGISTER, address);
+
+    }
+
+    // Writing the tail descriptor starts the processing of the descriptors up to it (SG mode, running)
+    void MM2SSetTailDescriptor(uint32_t address) {
+
+        writeAXI(MM2S_TAILDESC_REGISTER, address);
+
+    }
+
+    void S2MMSetTailDescriptor(uint32_t address) {
+
+        writeAXI(S2MM_TAILDESC_REGISTER, address);
+
+    }
+
+    // Starts the channel on the descriptors pushed in the ring, the channel must be halted (after a reset)
+    void MM2SStartSG(SGRing &ring) {
+
+        MM2SSetCurrentDescriptor(ring.headAddress());
+        MM2SStart();
+        MM2SQueueSG(ring);
+
+    }
+
+    void S2MMStartSG(SGRing &ring) {
+
+        S2MMSetCurrentDescriptor(ring.headAddress());
+        S2MMStart();
+        S2MMQueueSG(ring);
+
+    }
+
+    // Hands the descriptors pushed since the last start / queue to the running channel
+    void MM2SQueueSG(SGRing &ring) {
+
+        if (ring.inFlight() == 0) {
+            return;
+        }
+        dma_barrier(); // Descriptors written before the DMA fetches them
+        MM2SSetTailDescriptor(ring.tailAddress());
+
+    }
+
+    void S2MMQueueSG(SGRing &ring) {
+
+        if (ring.inFlight() == 0) {
+            return;
+        }
+        dma_barrier();
+        S2MMSetTailDescriptor(ring.tailAddress());
 
     }
 
@@ -293,13 +657,45 @@ public:
     
 private:
 
+    int device_file;
+    unsigned int map_size;             // 0 if the registers are not mapped by the controller
+    size_t interrupt_count_size;       // Bytes read from device_file per interrupt wait
+    RegisterWriteHook write_hook;
+
+    // volatile: the registers are polled, every access must reach the device
     unsigned int writeAXI(uint32_t offset, uint32_t value) {
-        uio_map[offset>>2] = value;
+        if (write_hook) {
+            write_hook(offset, value);
+            return 0;
+        }
+        ((volatile uint32_t *)uio_map)[offset>>2] = value;
         return 0;
     }
 
     unsigned int readAXI(uint32_t offset) {
-        return uio_map[offset>>2];
+        return ((volatile uint32_t *)uio_map)[offset>>2];
+    }
+
+    void waitReset(uint32_t control_register) {
+
+        for (unsigned int i = 0; i < DMA_RESET_TIMEOUT_POLLS && (readAXI(control_register) & RESET_DMA); i++) {}
+
+    }
+
+    uint32_t waitForCompletion(uint32_t status_register, int timeout_ms) {
+
+        for (;;) {
+            uint32_t flags = readAXI(status_register) & ALL_IRQ_FLAGS;
+            if (flags != 0) {
+                writeAXI(status_register, flags);
+                return flags;
+            }
+            // An interrupt raised before the arming is still pending (level), poll returns right away
+            if (!InterruptArm() || !InterruptWait(timeout_ms)) {
+                return 0;
+            }
+        }
+
     }
 
     unsigned int getMM2SStatus() {
@@ -12,6 +12,8 @@
 #include <linux/slab.h>
 #include <asm/io.h>
 
+#include "../reservedmemLKM_ioctl.h"
+
 MODULE_AUTHOR("Thor Kamp Opstrup");
 MODULE_DESCRIPTION("Linux Kernel Module, to acces reserved memory from user space");
 
@@ -21,13 +23,16 @@ MODULE_DESCRIPTION("Linux Kernel Module, to acces reserved memory from user spac
 #define P_OFFSET 0x70000000 //!UPDATE TO YOUR PHYSICAL MEMORY OFFSET
 #define P_LENGTH 0x01000000 //!UPDATE TO YOUR PHYSICAL MEMORY LENGTH
 
+#define BOUNCE_LENGTH (16 * PAGE_SIZE) // Bytes copied from / to the user space at once
+
 static struct class *class;
 static struct device *device;
 static int major;
 
 static void *pmem = NULL;
+static void *bounce = NULL; // kernel copy of the user data, pmem is io memory (memcpy_toio / memcpy_fromio)
 
-static DEFINE_MUTEX(reservedmemLKM_action_mutex); //! update to action mutex
+static DEFINE_MUTEX(reservedmemLKM_action_mutex); // copies to / from pmem, guards bounce
 
 /*  executed once the device is closed or releaseed by userspace
  *  @param inodep: pointer to struct inode
@@ -45,59 +50,103 @@ static int f_close(struct inode *inodep, struct file *filep)
 static int f_open(struct inode *inodep, struct file *filep)
 {
     int ret = 0;
+    filep->private_data = (void *)RESERVEDMEM_MAP_WRITECOMBINE; // memory type of the mmap calls on this file
     pr_info("reserved_mem: Device opened\n");
     return ret;
 }
 
-/*  executed when the user calls read to file //!SOMEHOW memcpy_fromio IS REALLY SLOW
- * the information in the buffer should be uint32_t[_offset, length, u_buffer_low, u_buffer_high]
- * Once called the data with "length(Bytes)" (from above) parameter is read from pmem (starting at p_offset) to
- * user buffer
+/*  copies one segment between its user buffer and pmem, in chunks of BOUNCE_LENGTH
+ * reservedmemLKM_action_mutex must be held
  */
-static ssize_t f_read(struct file *filep, char *buffer, size_t len, loff_t *offset)
+static int copy_segment(const struct reservedmem_segment *segment)
 {
-    int ret;
-    int i;
-    uint32_t p_offset = 0;
-    uint32_t read_length = 0;
-    uintptr_t u_buffer_ptr = 0;
+    char __user *u_buffer = (char __user *)(uintptr_t)segment->user_buffer;
+    uint32_t done = 0;
+    uint32_t chunk;
 
-    if (!mutex_trylock(&reservedmemLKM_action_mutex))
+    if (segment->offset > P_LENGTH || segment->length > P_LENGTH - segment->offset)
     {
-        pr_alert("reservedmemLKM: device busy!\n");
-        ret = -EBUSY;
-        goto out;
+        pr_err("reservedmemLKM: copy fault requested segment is out of bound\n");
+        return -EINVAL;
+    }
+    if (segment->direction != RESERVEDMEM_TO_DEVICE && segment->direction != RESERVEDMEM_FROM_DEVICE)
+    {
+        return -EINVAL;
     }
 
-    p_offset = (buffer[0] |
-                (buffer[1] << 8) |
-                (buffer[2] << 16) |
-                (buffer[3] << 24));
-    read_length = (buffer[4] |
-                   (buffer[5] << 8) |
-                   (buffer[6] << 16) |
-                   (buffer[7] << 24));
-    for (i = 8; i < 15 + 1; i++)
+    while (done < segment->length)
     {
-        u_buffer_ptr |= ((uintptr_t)buffer[i] << ((i - 8) * 8));
+        chunk = min_t(uint32_t, segment->length - done, BOUNCE_LENGTH);
+        if (segment->direction == RESERVEDMEM_TO_DEVICE)
+        {
+            if (copy_from_user(bounce, u_buffer + done, chunk))
+            {
+                return -EFAULT;
+            }
+            memcpy_toio((uint8_t *)pmem + segment->offset + done, bounce, chunk);
+        }
+        else
+        {
+            memcpy_fromio(bounce, (uint8_t *)pmem + segment->offset + done, chunk);
+            if (copy_to_user(u_buffer + done, bounce, chunk))
+            {
+                return -EFAULT;
+            }
+        }
+        done += chunk;
     }
+    return 0;
+}
 
-    if ((p_offset * sizeof(uint32_t) + read_length) > P_LENGTH)
+/*  decodes the buffer of read / write, uint32_t[p_offset, length, u_buffer_low, u_buffer_high] with p_offset
+ * in 32-bit words, into a segment
+ */
+static int info_segment(const char __user *buffer, size_t len, uint32_t direction, struct reservedmem_segment *segment)
+{
+    uint32_t info[4];
+
+    if (len < sizeof(info) || copy_from_user(info, buffer, sizeof(info)))
     {
-        pr_err("reservedmemLKM: read fault requested read dst is out of bound\n");
-        ret = -EFAULT;
-        goto out;
+        return -EFAULT;
     }
+    if (info[0] > P_LENGTH / sizeof(uint32_t))
+    {
+        pr_err("reservedmemLKM: requested p_offset is out of bound\n");
+        return -EINVAL;
+    }
+    segment->offset = info[0] * sizeof(uint32_t);
+    segment->length = info[1];
+    segment->user_buffer = (uint64_t)info[2] | ((uint64_t)info[3] << 32);
+    segment->direction = direction;
+    segment->reserved = 0;
+    return 0;
+}
 
-    // printk("start read!\n");
-    memcpy_fromio((uint32_t *)u_buffer_ptr, (uint32_t *)pmem + p_offset, read_length);
-    // printk("done!\n");
-    ret = 1; //! THIS IS NOT CONVENTION
+/*  executed when the user calls read to file
+ * the information in the buffer should be uint32_t[_offset, length, u_buffer_low, u_buffer_high]
+ * Once called the data with "length(Bytes)" (from above) parameter is read from pmem (starting at p_offset) to
+ * user buffer
+ * Waits while another call copies (interruptible)
+ */
+static ssize_t f_read(struct file *filep, char __user *buffer, size_t len, loff_t *offset)
+{
+    int ret;
+    struct reservedmem_segment segment;
 
-out:
-    // pr_info("data read\n");
+    ret = info_segment(buffer, len, RESERVEDMEM_FROM_DEVICE, &segment);
+    if (ret)
+    {
+        return ret;
+    }
+
+    if (mutex_lock_interruptible(&reservedmemLKM_action_mutex))
+    {
+        return -ERESTARTSYS;
+    }
+    ret = copy_segment(&segment);
     mutex_unlock(&reservedmemLKM_action_mutex);
-    return ret;
+
+    return ret ? ret : 1; //! THIS IS NOT CONVENTION
 }
 
 
@@ -106,63 +155,141 @@ out:
  * Once called the data from user buffer with "length(Bytes)"(from above) parameter is written from user buffer to
  * physical memory at the specified start(P_OFFSET) and "p_offset"(from above)
  * Returns the number of Bytes written
+ * Waits while another call copies (interruptible)
  */
-static ssize_t f_write(struct file *filep, const char *buffer, size_t len, loff_t *offset)
+static ssize_t f_write(struct file *filep, const char __user *buffer, size_t len, loff_t *offset)
 {
     int ret;
-    int i;
-    uint32_t p_offset = 0;
-    uint32_t write_length = 0;
-    uintptr_t u_buffer_ptr = 0;
+    struct reservedmem_segment segment;
 
-    if (!mutex_trylock(&reservedmemLKM_action_mutex))
+    ret = info_segment(buffer, len, RESERVEDMEM_TO_DEVICE, &segment);
+    if (ret)
     {
-        pr_alert("reservedmemLKM: device busy!\n");
-        ret = -EBUSY;
-        goto out;
+        return ret;
     }
-    
-    p_offset = (buffer[0] |
-                (buffer[1] << 8) |
-                (buffer[2] << 16) |
-                (buffer[3] << 24));
-    write_length = (buffer[4] |
-                    (buffer[5] << 8) |
-                    (buffer[6] << 16) |
-                    (buffer[7] << 24));
-    for (i = 8; i < 15 + 1; i++)
+
+    if (mutex_lock_interruptible(&reservedmemLKM_action_mutex))
     {
-        u_buffer_ptr |= ((uintptr_t)buffer[i] << ((i - 8) * 8));
+        return -ERESTARTSYS;
     }
-    // pr_info("u_buffer: 0x%lx\n", u_buffer_ptr);
-    printk("p_offset: %i ", p_offset);
-    printk("write_length: %i ", write_length);
-    printk("P_LENGTH: %i\n", P_LENGTH);
-    pr_info("u_buffer: 0x%lx\n", u_buffer_ptr);
+    ret = copy_segment(&segment);
+    mutex_unlock(&reservedmemLKM_action_mutex);
 
-    if ((p_offset * sizeof(uint32_t) + write_length) > P_LENGTH)
-    {
-        pr_err("reservedmemLKM: write fault requested writing dst is out of bound\n");
+    return ret ? ret : segment.length * sizeof(uint32_t); //! THIS IS NOT CONVENTION
+}
 
-        ret = -EFAULT;
-        goto out;
-    }
+/*  copies the segments of a batch (RESERVEDMEM_IOC_TRANSFER) in order, under one lock
+ * stops at the first failing segment, the number of segments copied is written back to done
+ */
+static long transfer_batch(struct reservedmem_transfer __user *u_transfer)
+{
+    long ret = 0;
+    uint32_t done;
+    struct reservedmem_transfer transfer;
+    struct reservedmem_segment segment;
+    const struct reservedmem_segment __user *u_segments;
 
-    // printk("start write!\n");
-    memcpy_toio((uint32_t *)pmem + p_offset, (uint32_t *)u_buffer_ptr, write_length);
-    // printk("done!\n");
-    ret = write_length * sizeof(uint32_t); //! THIS IS NOT CONVENTION
+    if (copy_from_user(&transfer, u_transfer, sizeof(transfer)))
+    {
+        return -EFAULT;
+    }
+    u_segments = (const struct reservedmem_segment __user *)(uintptr_t)transfer.segments;
 
-    pr_info("data written\n");
+    if (mutex_lock_interruptible(&reservedmemLKM_action_mutex))
+    {
+        return -ERESTARTSYS;
+    }
+    for (done = 0; done < transfer.count; done++)
+    {
+        if (copy_from_user(&segment, u_segments + done, sizeof(segment)))
+        {
+            ret = -EFAULT;
+            break;
+        }
+        ret = copy_segment(&segment);
+        if (ret)
+        {
+            break;
+        }
+    }
     mutex_unlock(&reservedmemLKM_action_mutex);
-out:
+
+    if (put_user(done, &u_transfer->done))
+    {
+        return -EFAULT;
+    }
     return ret;
 }
 
+/*  executed when the user calls mmap on the file
+ * Maps the reserved memory in the user space, starting at the page given by the mmap offset (vma->vm_pgoff)
+ * The memory type is the one selected on the file with RESERVEDMEM_IOC_MAP_MODE:
+ *  - write combining (default): non-cacheable, so the CPU and the DMA see the same data without cache
+ *    maintenance, but unlike the device memory type of ioremap_nocache it allows unaligned accesses (memcpy)
+ *  - uncached: device memory like pmem
+ *  - cached: full speed CPU accesses, the user must clean / invalidate the caches around the DMA transfers
+ *    (Reserved_Mem::sync_for_device / sync_for_cpu, by virtual address from user space)
+ */
+static int f_mmap(struct file *filep, struct vm_area_struct *vma)
+{
+    unsigned long length = vma->vm_end - vma->vm_start;
+
+    if (vma->vm_pgoff >= (P_LENGTH >> PAGE_SHIFT) ||
+        length > P_LENGTH - (vma->vm_pgoff << PAGE_SHIFT))
+    {
+        pr_err("reservedmemLKM: mmap fault requested mapping is out of bound\n");
+        return -EINVAL;
+    }
+
+    switch ((uintptr_t)filep->private_data)
+    {
+    case RESERVEDMEM_MAP_UNCACHED:
+        vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+        break;
+    case RESERVEDMEM_MAP_CACHED:
+        break;
+    default:
+        vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+        break;
+    }
+    if (remap_pfn_range(vma, vma->vm_start, (P_OFFSET >> PAGE_SHIFT) + vma->vm_pgoff, length, vma->vm_page_prot))
+    {
+        pr_err("reservedmemLKM: could not map the reserved memory\n");
+        return -EAGAIN;
+    }
+    return 0;
+}
+
+/*  executed when the user calls ioctl on the file (commands in reservedmemLKM_ioctl.h)
+ * RESERVEDMEM_IOC_MAP_MODE: arg is the memory type (RESERVEDMEM_MAP_*) of the next mmap calls on this file
+ * RESERVEDMEM_IOC_TRANSFER: arg points to a struct reservedmem_transfer, see transfer_batch
+ */
+static long f_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
+{
+    switch (cmd)
+    {
+    case RESERVEDMEM_IOC_MAP_MODE:
+        if (arg != RESERVEDMEM_MAP_UNCACHED && arg != RESERVEDMEM_MAP_WRITECOMBINE && arg != RESERVEDMEM_MAP_CACHED)
+        {
+            return -EINVAL;
+        }
+        filep->private_data = (void *)arg;
+        return 0;
+
+    case RESERVEDMEM_IOC_TRANSFER:
+        return transfer_batch((struct reservedmem_transfer __user *)arg);
+
+    default:
+        return -ENOTTY;
+    }
+}
+
 static const struct file_operations reservedmemLKM_fops = {
     .open = f_open,
     .read = f_read,
     .write = f_write,
+    .mmap = f_mmap,
+    .unlocked_ioctl = f_ioctl,
     .release = f_close,
     //set the owner of the file operations to all users (0666)
 };
@@ -218,6 +345,15 @@ static int __init reservedmemLKM_init(void)
         goto out;
     }
 
+    bounce = kmalloc(BOUNCE_LENGTH, GFP_KERNEL);
+    if (bounce == NULL)
+    {
+        pr_err("reservedmemLKM: could not allocate the bounce buffer\n");
+        iounmap(pmem);
+        ret = -ENOMEM;
+        goto out;
+    }
+
     mutex_init(&reservedmemLKM_action_mutex);
 
     printk("reservedmemLKM inserted!\n");
@@ -231,6 +367,7 @@ static void __exit reservedmemLKM_exit(void)
     class_unregister(class);
     class_destroy(class);
     iounmap(pmem);
+    kfree(bounce);
     unregister_chrdev(major, DRIVER_NAME);
 
     mutex_destroy(&reservedmemLKM_action_mutex);
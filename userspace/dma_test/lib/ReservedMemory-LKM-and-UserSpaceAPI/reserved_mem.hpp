@@ -8,12 +8,18 @@
 #include <errno.h>
 #include <stdint.h>
 #include <fcntl.h>
+#include <sys/ioctl.h>
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
+
+#include "reservedmemLKM_ioctl.h"
 
 /******************************* Defines **********************************/
 #define DEVICE_FILENAME "/dev/reservedmemLKM"
 #define MAX_LENGTH 0x01000000 // Bytes
+#define PHYSICAL_START 0x70000000 // Physical address of the reserved memory (P_OFFSET of the LKM)
 
 #define i_P_START 0
 #define i_LENGTH 1
@@ -27,11 +33,174 @@ private:
     int memLKM;             // file
     uint32_t write_info[4]; // [p_offset, length, u_buffer_low, u_buffer_high]
     uint32_t read_info[4];  // [p_offset, length, u_buffer_low, u_buffer_high]
+    void *mapping;          // whole reserved memory mapped by map(), MAP_FAILED until then
+    bool simulated;         // memLKM is a plain memory file (AXIDMASim), without the LKM read/write/ioctl
+    struct Buffer
+    {
+        void *address;
+        size_t length;
+        uint32_t offset; // in the reserved memory (bytes)
+        int mode;        // RESERVEDMEM_MAP_*
+    };
+    std::vector<Buffer> buffers; // mappings of map_buffer()
+
+    // simulated memory of a transfer/gather, p_offset in 32-bit words like the LKM, nullptr if out of bound
+    uint8_t *simulated_data(int p_offset, int length)
+    {
+        if (p_offset < 0 || length < 0 || (uint64_t)p_offset * 4 + length > MAX_LENGTH || !map())
+        {
+            return nullptr;
+        }
+        return (uint8_t *)mapping + p_offset * 4;
+    };
+
+    // cleans (clean_only) or cleans and invalidates the data cache lines of [start, start + length) to the point
+    // of coherency, by virtual address from user space (allowed by Linux on arm64, SCTLR_EL1.UCI)
+    // the reserved memory is outside the kernel linear map, so the kernel has no cacheable address to do it on
+    static void cache_maintenance(uint8_t *start, size_t length, bool clean_only)
+    {
+#if defined(__aarch64__)
+        uint64_t ctr;
+        asm volatile("mrs %0, ctr_el0" : "=r"(ctr));
+        uintptr_t line = 4 << ((ctr >> 16) & 0xF); // smallest data cache line (CTR_EL0.DminLine, in words)
+        for (uintptr_t address = (uintptr_t)start & ~(line - 1); address < (uintptr_t)start + length; address += line)
+        {
+            if (clean_only)
+            {
+                asm volatile("dc cvac, %0" : : "r"(address) : "memory");
+            }
+            else
+            {
+                asm volatile("dc civac, %0" : : "r"(address) : "memory");
+            }
+        }
+        asm volatile("dsb sy" : : : "memory");
+#else
+        // coherent DMA (simulator, x86 host): nothing to do
+        (void)start;
+        (void)length;
+        (void)clean_only;
+#endif
+    };
+
+    // cache maintenance of the cached mappings of map_buffer() covering [offset, offset + length)
+    int sync(uint32_t offset, uint32_t length, bool clean_only)
+    {
+        if (offset > MAX_LENGTH || length > MAX_LENGTH - offset)
+        {
+            return -1;
+        }
+        for (const Buffer &buffer : buffers)
+        {
+            uint64_t start = std::max<uint64_t>(offset, buffer.offset);
+            uint64_t end = std::min<uint64_t>((uint64_t)offset + length, (uint64_t)buffer.offset + buffer.length);
+            if (buffer.mode == RESERVEDMEM_MAP_CACHED && start < end)
+            {
+                cache_maintenance((uint8_t *)buffer.address + (start - buffer.offset), end - start, clean_only);
+            }
+        }
+        return 0;
+    };
 
 public:
     Reserved_Mem()
     {
         memLKM = open(DEVICE_FILENAME, O_RDWR | O_NDELAY);
+        mapping = MAP_FAILED;
+        simulated = false;
+    };
+
+    // reserved memory simulated by a memory file of MAX_LENGTH bytes (see AXIDMASim::memoryFileDescriptor)
+    // the file is duplicated, the map modes are ignored and transfer/gather copy through the mapping
+    explicit Reserved_Mem(int memory_fd)
+    {
+        memLKM = dup(memory_fd);
+        mapping = MAP_FAILED;
+        simulated = true;
+    };
+
+    Reserved_Mem(const Reserved_Mem &) = delete;
+    Reserved_Mem &operator=(const Reserved_Mem &) = delete;
+
+    // maps the whole reserved memory in the user space (write combining), only done on the first call
+    // returns false if the device could not be opened or mapped
+    bool map()
+    {
+        if (mapping == MAP_FAILED && memLKM >= 0 &&
+            (simulated || ioctl(memLKM, RESERVEDMEM_IOC_MAP_MODE, RESERVEDMEM_MAP_WRITECOMBINE) == 0))
+        {
+            mapping = mmap(NULL, MAX_LENGTH, PROT_READ | PROT_WRITE, MAP_SHARED, memLKM, 0);
+        }
+        return mapping != MAP_FAILED;
+    };
+
+    // maps length bytes of the reserved memory from the given offset (in bytes, page aligned) with a memory type
+    // RESERVEDMEM_MAP_UNCACHED, RESERVEDMEM_MAP_WRITECOMBINE or RESERVEDMEM_MAP_CACHED
+    // a cached buffer needs sync_for_device() before the DMA reads or writes it and sync_for_cpu() after it wrote it
+    // returns nullptr on failure, the mapping lasts until unmap_buffer() or the destruction
+    template <typename T>
+    T *map_buffer(uint32_t offset, uint32_t length, int mode)
+    {
+        if (memLKM < 0 || (!simulated && ioctl(memLKM, RESERVEDMEM_IOC_MAP_MODE, mode) != 0))
+        {
+            return nullptr;
+        }
+        void *buffer = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, memLKM, offset);
+        if (buffer == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        Buffer mapped = {buffer, (size_t)length, offset, mode};
+        buffers.push_back(mapped);
+        return (T *)buffer;
+    };
+
+    void unmap_buffer(void *buffer)
+    {
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            if (buffers[i].address == buffer)
+            {
+                munmap(buffers[i].address, buffers[i].length);
+                buffers.erase(buffers.begin() + i);
+                return;
+            }
+        }
+    };
+
+    // cleans length bytes from the given offset (in bytes) from the CPU caches, through the cached mappings
+    // to call on a cached buffer after the CPU wrote it and before starting the DMA on it (MM2S and S2MM)
+    // returns -1 if the range is out of bound
+    int sync_for_device(uint32_t offset, uint32_t length)
+    {
+        return sync(offset, length, true);
+    };
+
+    // invalidates length bytes from the given offset (in bytes) in the CPU caches, through the cached mappings
+    // (clean and invalidate: user space cannot invalidate only, the lines are clean after sync_for_device())
+    // to call on a cached buffer once the DMA wrote it (S2MM) and before the CPU reads it
+    int sync_for_cpu(uint32_t offset, uint32_t length)
+    {
+        return sync(offset, length, false);
+    };
+
+    // pointer to the reserved memory at the given offset (in bytes, unlike transfer/gather), mapping it if needed
+    // data written through it is directly seen by the DMA, no transfer is needed
+    // returns nullptr if the offset is out of bound or the memory could not be mapped
+    template <typename T>
+    T *data(uint32_t offset = 0)
+    {
+        if (offset >= MAX_LENGTH || !map())
+        {
+            return nullptr;
+        }
+        return (T *)((uint8_t *)mapping + offset);
+    };
+
+    // physical address of the given offset (in bytes), to give to the DMA
+    uint32_t physical_address(uint32_t offset = 0) const
+    {
+        return PHYSICAL_START + offset;
     };
 
     // writes any type of user buffer to the reserved memory at the given offset
@@ -40,6 +209,16 @@ public:
     uint32_t transfer(T *src, int p_offset, int length)
     {
         int ret;
+        if (simulated)
+        {
+            uint8_t *memory = simulated_data(p_offset, length);
+            if (memory == nullptr)
+            {
+                return -1;
+            }
+            memcpy(memory, src, length);
+            return length * 4; // same return as the LKM
+        }
         write_info[i_P_START] = p_offset;
         write_info[i_LENGTH] = length;
         // std::cout << "length: " << write_info[i_LENGTH] << std::endl;
@@ -56,6 +235,16 @@ public:
     uint32_t gather(T *dst, int p_offset, int length)
     {
         int ret;
+        if (simulated)
+        {
+            uint8_t *memory = simulated_data(p_offset, length);
+            if (memory == nullptr)
+            {
+                return -1;
+            }
+            memcpy(dst, memory, length);
+            return 1; // same return as the LKM
+        }
         read_info[i_P_START] = p_offset;
         read_info[i_LENGTH] = length;
 
@@ -67,8 +256,61 @@ public:
         return ret;
     };
 
+    // segment for transferv(): length bytes between the user buffer and the reserved memory at the given offset
+    // (in bytes, unlike transfer/gather), direction RESERVEDMEM_TO_DEVICE or RESERVEDMEM_FROM_DEVICE
+    template <typename T>
+    static struct reservedmem_segment segment(T *buffer, uint32_t offset, uint32_t length, uint32_t direction)
+    {
+        struct reservedmem_segment s = {offset, length, (__u64)(uintptr_t)buffer, direction, 0};
+        return s;
+    };
+
+    // copies count segments (transfers and gathers) in order with one call to the LKM, waiting for the other
+    // threads instead of failing while they copy
+    // returns the number of segments copied, less than count if a segment is out of bound or faulted
+    uint32_t transferv(const struct reservedmem_segment *segments, uint32_t count)
+    {
+        if (simulated)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const struct reservedmem_segment &s = segments[i];
+                if (s.offset > MAX_LENGTH || s.length > MAX_LENGTH - s.offset || !map())
+                {
+                    return i;
+                }
+                uint8_t *memory = (uint8_t *)mapping + s.offset;
+                uint8_t *buffer = (uint8_t *)(uintptr_t)s.user_buffer;
+                if (s.direction == RESERVEDMEM_TO_DEVICE)
+                {
+                    memcpy(memory, buffer, s.length);
+                }
+                else if (s.direction == RESERVEDMEM_FROM_DEVICE)
+                {
+                    memcpy(buffer, memory, s.length);
+                }
+                else
+                {
+                    return i;
+                }
+            }
+            return count;
+        }
+        struct reservedmem_transfer batch = {(__u64)(uintptr_t)segments, count, 0};
+        ioctl(memLKM, RESERVEDMEM_IOC_TRANSFER, &batch); // done tells how far it went on error
+        return batch.done;
+    };
+
     ~Reserved_Mem()
     {
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            munmap(buffers[i].address, buffers[i].length);
+        }
+        if (mapping != MAP_FAILED)
+        {
+            munmap(mapping, MAX_LENGTH);
+        }
         close(memLKM);
     };
 };
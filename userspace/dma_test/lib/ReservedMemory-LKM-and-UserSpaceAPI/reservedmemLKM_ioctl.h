@@ -0,0 +1,39 @@
+#pragma once
+/* ioctl interface of reservedmemLKM, shared by the LKM and the user space API (reserved_mem.hpp) */
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/* memory types of the user space mappings, selected with RESERVEDMEM_IOC_MAP_MODE before mmap */
+#define RESERVEDMEM_MAP_UNCACHED 0     /* device memory, aligned accesses only */
+#define RESERVEDMEM_MAP_WRITECOMBINE 1 /* non-cacheable normal memory, default */
+#define RESERVEDMEM_MAP_CACHED 2       /* cacheable, needs Reserved_Mem::sync_for_device / sync_for_cpu around the DMA */
+
+/* directions of the copy segments */
+#define RESERVEDMEM_TO_DEVICE 0   /* user buffer to reserved memory (Reserved_Mem::transfer) */
+#define RESERVEDMEM_FROM_DEVICE 1 /* reserved memory to user buffer (Reserved_Mem::gather) */
+
+/* one copy between a user buffer and the reserved memory (offset in bytes) */
+struct reservedmem_segment
+{
+    __u32 offset;
+    __u32 length;
+    __u64 user_buffer; /* user space address */
+    __u32 direction;   /* RESERVEDMEM_TO_DEVICE or RESERVEDMEM_FROM_DEVICE */
+    __u32 reserved;
+};
+
+/* batch of copies, done in order in one call */
+struct reservedmem_transfer
+{
+    __u64 segments; /* user space address of count struct reservedmem_segment */
+    __u32 count;
+    __u32 done;     /* set by the LKM: segments copied, less than count on error */
+};
+
+#define RESERVEDMEM_IOC_MAGIC 'r'
+/* memory type (RESERVEDMEM_MAP_*) of the next mmap calls on the file */
+#define RESERVEDMEM_IOC_MAP_MODE _IO(RESERVEDMEM_IOC_MAGIC, 1)
+/* 2 and 3 are unused: the cache maintenance is done from user space on the cached mappings (reserved_mem.hpp),
+ * the reserved memory is outside the kernel linear map */
+/* copies the segments of the batch, waits (instead of failing) while another call uses the reserved memory */
+#define RESERVEDMEM_IOC_TRANSFER _IOWR(RESERVEDMEM_IOC_MAGIC, 4, struct reservedmem_transfer)
@@ -0,0 +1,515 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "axi_dma_controller.h"
+#include "reserved_mem.hpp"
+
+#define SIM_REGISTERS_SIZE 0x10000 // Bytes, as the UIO map of the DMA
+#define SIM_RESET_CONTROL  0x00010000 // Control register after a reset (IRQ threshold of 1)
+#define SIM_SPIN_US        200        // Stream delays shorter than the timer slack are spun
+
+// Software stand-in of the AXI DMA and of the reserved memory, to run the DMA code without the board.
+// The reserved memory is a memory file (Reserved_Mem(memoryFileDescriptor())) at physical addresses
+// physical_base.., the register block is a memory page read by the controller (AXIDMAController(registers(),
+// writeHook(), interruptFileDescriptor())) whose writes go to the simulator, which applies them as the
+// hardware: run / halt / reset, write 1 to clear of the status, start on the length (simple mode) or on the
+// tail descriptor (scatter gather mode).
+// A worker thread moves the data: MM2S reads the packet (one transfer, or descriptors up to EOF), the stream IP
+// turns it into the output packet (loop back by default), S2MM writes it to its buffer(s), short packets
+// included. Each channel raises IOC (with IDLE, or the descriptor status) and the interrupt on the eventfd.
+// Timing: each MM2S transfer / descriptor takes latency_us plus its length at bandwidth_mb_s (0: no limit),
+// S2MM overlaps it. Unlike the hardware, a packet waits without limit for S2MM buffers (no back pressure on MM2S).
+class AXIDMASim {
+public:
+    // Stream IP between MM2S and S2MM: returns the length of the output packet written to out (up to out_capacity,
+    // the length of the input packet)
+    typedef std::function<uint32_t(const uint8_t *in, uint32_t in_length, uint8_t *out, uint32_t out_capacity)> StreamIP;
+
+    // scatter_gather: DMA built with the scatter gather engine (STATUS_SG_INCLDED), simple mode otherwise
+    AXIDMASim(bool scatter_gather = false, double bandwidth_mb_s = 0, double latency_us = 0, StreamIP ip = StreamIP(),
+              uint32_t physical_base = PHYSICAL_START, uint32_t memory_length = MAX_LENGTH)
+        : scatter_gather(scatter_gather), bandwidth_mb_s(bandwidth_mb_s), latency_us(latency_us), ip(ip),
+          physical_base(physical_base), memory_length(memory_length), generation(0), stopping(false) {
+
+        memory_fd = memfd_create("axi_dma_sim_memory", 0);
+        registers_fd = memfd_create("axi_dma_sim_registers", 0);
+        interrupt_fd = eventfd(0, EFD_NONBLOCK);
+        if (memory_fd < 0 || registers_fd < 0 || interrupt_fd < 0 ||
+            ftruncate(memory_fd, memory_length) != 0 || ftruncate(registers_fd, SIM_REGISTERS_SIZE) != 0) {
+            closeFiles();
+            throw std::string("DMA simulator files could not be created");
+        }
+
+        memory = (uint8_t *)mmap(NULL, memory_length, PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd, 0);
+        register_map = (uint32_t *)mmap(NULL, SIM_REGISTERS_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, registers_fd, 0);
+        if (memory == MAP_FAILED || register_map == MAP_FAILED) {
+            unmap();
+            closeFiles();
+            throw std::string("DMA simulator files could not be mapped");
+        }
+
+        mm2s = Channel(MM2S_CONTROL_REGISTER, MM2S_STATUS_REGISTER, MM2S_CURDESC_REGISTER, MM2S_TAILDESC_REGISTER,
+                       MM2S_SRC_ADDRESS_REGISTER, MM2S_TRNSFR_LENGTH_REGISTER);
+        s2mm = Channel(S2MM_CONTROL_REGISTER, S2MM_STATUS_REGISTER, S2MM_CURDESC_REGISTER, S2MM_TAILDESC_REGISTER,
+                       S2MM_DST_ADDRESS_REGISTER, S2MM_BUFF_LENGTH_REGISTER);
+        reset();
+
+        worker = std::thread(&AXIDMASim::run, this);
+
+    }
+
+    AXIDMASim(const AXIDMASim &) = delete;
+    AXIDMASim &operator=(const AXIDMASim &) = delete;
+
+    // The controllers and Reserved_Mem using the simulator must be destroyed first
+    ~AXIDMASim() {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+        unmap();
+        closeFiles();
+
+    }
+
+    // Memory file of the simulated reserved memory, for Reserved_Mem(int)
+    int memoryFileDescriptor() const {
+
+        return memory_fd;
+
+    }
+
+    // eventfd signaled on each interrupt (flag raised with its interrupt enabled)
+    int interruptFileDescriptor() const {
+
+        return interrupt_fd;
+
+    }
+
+    uint32_t *registers() const {
+
+        return register_map;
+
+    }
+
+    AXIDMAController::RegisterWriteHook writeHook() {
+
+        return [this](uint32_t offset, uint32_t value) { write(offset, value); };
+
+    }
+
+    // Register write from the CPU, with its side effects
+    void write(uint32_t offset, uint32_t value) {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Channel *channel = (offset < S2MM_CONTROL_REGISTER) ? &mm2s : &s2mm;
+            writeRegister(*channel, offset, value);
+        }
+        wake.notify_all();
+
+    }
+
+private:
+    // Registers and progress of one channel
+    struct Channel {
+        uint32_t control_register;
+        uint32_t status_register;
+        uint32_t curdesc_register;
+        uint32_t taildesc_register;
+        uint32_t address_register;
+        uint32_t length_register;
+        bool transfer_pending;     // Simple mode: length written, transfer not done
+        bool descriptors_pending;  // Scatter gather mode: descriptors to process up to the tail
+        uint32_t next_descriptor;  // Scatter gather mode: next descriptor to process
+
+        Channel() {}
+
+        Channel(uint32_t control, uint32_t status, uint32_t curdesc, uint32_t taildesc, uint32_t address, uint32_t length)
+            : control_register(control), status_register(status), curdesc_register(curdesc),
+              taildesc_register(taildesc), address_register(address), length_register(length),
+              transfer_pending(false), descriptors_pending(false), next_descriptor(0) {}
+    };
+
+    bool scatter_gather;
+    double bandwidth_mb_s;
+    double latency_us;
+    StreamIP ip;
+    uint32_t physical_base;
+    uint32_t memory_length;
+    int memory_fd;
+    int registers_fd;
+    int interrupt_fd;
+    uint8_t *memory;
+    uint32_t *register_map;
+    Channel mm2s;
+    Channel s2mm;
+    std::vector<uint8_t> mm2s_packet;           // MM2S data of the packet being read
+    std::deque<std::vector<uint8_t>> packets;   // Stream IP outputs waiting for S2MM
+    uint32_t packet_offset;                     // Bytes of packets.front() already written by S2MM
+    unsigned int generation;                    // Incremented by each reset, drops the transfer in progress
+    bool stopping;
+    std::mutex mutex;                           // Registers and channel state, between the CPU and the worker
+    std::condition_variable wake;
+    std::thread worker;
+
+    uint32_t readRegister(uint32_t offset) const {
+
+        return __atomic_load_n(&register_map[offset >> 2], __ATOMIC_ACQUIRE);
+
+    }
+
+    void storeRegister(uint32_t offset, uint32_t value) {
+
+        __atomic_store_n(&register_map[offset >> 2], value, __ATOMIC_RELEASE);
+
+    }
+
+    bool running(const Channel &channel) const {
+
+        return (readRegister(channel.control_register) & RUN_DMA) != 0;
+
+    }
+
+    // Resets both channels, as the reset bit of either channel does
+    void reset() {
+
+        memset(register_map, 0, SIM_REGISTERS_SIZE);
+        for (Channel *channel : {&mm2s, &s2mm}) {
+            storeRegister(channel->control_register, SIM_RESET_CONTROL);
+            storeRegister(channel->status_register, STATUS_HALTED | (scatter_gather ? STATUS_SG_INCLDED : 0));
+            channel->transfer_pending = false;
+            channel->descriptors_pending = false;
+        }
+        mm2s_packet.clear();
+        packets.clear();
+        packet_offset = 0;
+        generation++;
+
+    }
+
+    void writeRegister(Channel &channel, uint32_t offset, uint32_t value) {
+
+        uint32_t status = readRegister(channel.status_register);
+
+        if (offset == channel.control_register) {
+            if (value & RESET_DMA) {
+                reset();
+                return;
+            }
+            bool was_running = running(channel);
+            storeRegister(offset, value);
+            if (value & RUN_DMA) {
+                status &= ~STATUS_HALTED;
+                if (!was_running && scatter_gather) {
+                    channel.next_descriptor = readRegister(channel.curdesc_register);
+                }
+            }
+            else {
+                // Halts at once, the hardware finishes the transfer in progress first
+                status = (status | STATUS_HALTED) & ~STATUS_IDLE;
+                channel.transfer_pending = false;
+                channel.descriptors_pending = false;
+            }
+            storeRegister(channel.status_register, status);
+        }
+        else if (offset == channel.status_register) {
+            storeRegister(offset, status & ~(value & ALL_IRQ_FLAGS));
+        }
+        else if (offset == channel.length_register) {
+            storeRegister(offset, value);
+            if (!scatter_gather && running(channel) && (value & DMA_LENGTH_REGISTER_MASK) != 0) {
+                channel.transfer_pending = true;
+                storeRegister(channel.status_register, status & ~STATUS_IDLE);
+            }
+        }
+        else if (offset == channel.taildesc_register) {
+            storeRegister(offset, value);
+            if (scatter_gather && running(channel)) {
+                channel.descriptors_pending = true;
+                storeRegister(channel.status_register, status & ~STATUS_IDLE);
+            }
+        }
+        else if (offset < SIM_REGISTERS_SIZE) {
+            storeRegister(offset, value);
+        }
+
+    }
+
+    // Sets status flags, interrupt if enabled
+    void raise(Channel &channel, uint32_t flags) {
+
+        storeRegister(channel.status_register, readRegister(channel.status_register) | flags);
+        if (readRegister(channel.control_register) & flags & ENABLE_ALL_IRQ) {
+            uint64_t one = 1;
+            if (::write(interrupt_fd, &one, sizeof(one)) != sizeof(one)) {
+                // Counter saturated: the interrupt is pending anyway
+            }
+        }
+
+    }
+
+    // Error: the channel halts until the next reset
+    void fail(Channel &channel, uint32_t error) {
+
+        channel.transfer_pending = false;
+        channel.descriptors_pending = false;
+        storeRegister(channel.control_register, readRegister(channel.control_register) & ~RUN_DMA);
+        storeRegister(channel.status_register, readRegister(channel.status_register) | STATUS_HALTED);
+        raise(channel, error | STATUS_ERR_IRQ);
+
+    }
+
+    // Simulated memory at a physical address, nullptr if [address, address + length) is outside
+    uint8_t *translate(uint32_t address, uint32_t length) const {
+
+        if (address < physical_base || (uint64_t)address - physical_base + length > memory_length) {
+            return nullptr;
+        }
+        return memory + (address - physical_base);
+
+    }
+
+    volatile SGDescriptor *descriptor(uint32_t address) const {
+
+        if (address % SG_DESCRIPTOR_ALIGNMENT != 0) {
+            return nullptr;
+        }
+        return (volatile SGDescriptor *)translate(address, sizeof(SGDescriptor));
+
+    }
+
+    // Descriptor processed: status written after the buffer, then the channel moves to the next one
+    void completeDescriptor(Channel &channel, uint32_t address, volatile SGDescriptor *desc, uint32_t status) {
+
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        desc->status = status | SG_STATUS_COMPLETE;
+        storeRegister(channel.curdesc_register, address);
+        channel.next_descriptor = desc->next_descriptor;
+        if (address == readRegister(channel.taildesc_register)) {
+            channel.descriptors_pending = false;
+            raise(channel, STATUS_IDLE);
+        }
+        raise(channel, STATUS_IOC_IRQ);
+
+    }
+
+    // Waits for the stream time of length bytes, lock released, false if a reset or the stop happened meanwhile
+    bool streamDelay(std::unique_lock<std::mutex> &lock, uint32_t length) {
+
+        double us = latency_us + (bandwidth_mb_s > 0 ? length / bandwidth_mb_s : 0.);
+        if (us <= 0) {
+            return true;
+        }
+        unsigned int started = generation;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double, std::micro>(us);
+        if (us < SIM_SPIN_US) {
+            lock.unlock();
+            while (std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+            lock.lock();
+        }
+        else {
+            wake.wait_until(lock, deadline, [&] { return stopping || generation != started ||
+                                                          std::chrono::steady_clock::now() >= deadline; });
+        }
+        return !stopping && generation == started;
+
+    }
+
+    // End of the MM2S packet: through the stream IP to the S2MM queue
+    void endPacket() {
+
+        if (!ip) {
+            packets.push_back(std::move(mm2s_packet));
+        }
+        else {
+            std::vector<uint8_t> output(mm2s_packet.size());
+            uint32_t length = ip(mm2s_packet.data(), mm2s_packet.size(), output.data(), output.size());
+            output.resize(length < output.size() ? length : output.size());
+            packets.push_back(std::move(output));
+        }
+        mm2s_packet.clear();
+
+    }
+
+    // Reads one MM2S transfer or descriptor, false if there was nothing to do
+    bool stepMM2S(std::unique_lock<std::mutex> &lock) {
+
+        if (!running(mm2s)) {
+            return false;
+        }
+
+        if (!scatter_gather) {
+            if (!mm2s.transfer_pending) {
+                return false;
+            }
+            uint32_t length = readRegister(mm2s.length_register) & DMA_LENGTH_REGISTER_MASK;
+            const uint8_t *source = translate(readRegister(mm2s.address_register), length);
+            if (source == nullptr) {
+                fail(mm2s, STATUS_DMA_DECODE_ERR);
+                return true;
+            }
+            if (!streamDelay(lock, length)) {
+                return true;
+            }
+            mm2s_packet.insert(mm2s_packet.end(), source, source + length);
+            endPacket(); // TLAST on the last beat of each transfer
+            mm2s.transfer_pending = false;
+            raise(mm2s, STATUS_IOC_IRQ | STATUS_IDLE);
+            return true;
+        }
+
+        if (!mm2s.descriptors_pending) {
+            return false;
+        }
+        uint32_t address = mm2s.next_descriptor;
+        volatile SGDescriptor *desc = descriptor(address);
+        if (desc == nullptr) {
+            fail(mm2s, STATUS_SG_DECODE_ERR);
+            return true;
+        }
+        if (desc->status & SG_STATUS_COMPLETE) {
+            fail(mm2s, STATUS_SG_INTERNAL_ERR); // Descriptor not reused by the software
+            return true;
+        }
+        uint32_t control = desc->control;
+        uint32_t length = control & SG_CONTROL_LENGTH_MASK;
+        const uint8_t *source = translate(desc->buffer_address, length);
+        if (source == nullptr) {
+            desc->status = SG_STATUS_DECODE_ERR | SG_STATUS_COMPLETE;
+            fail(mm2s, STATUS_DMA_DECODE_ERR);
+            return true;
+        }
+        if (!streamDelay(lock, length)) {
+            return true;
+        }
+        mm2s_packet.insert(mm2s_packet.end(), source, source + length);
+        if (control & SG_CONTROL_EOF) {
+            endPacket();
+        }
+        completeDescriptor(mm2s, address, desc, length);
+        return true;
+
+    }
+
+    // Writes the oldest output packet to one S2MM transfer or descriptor, false if there was nothing to do
+    bool stepS2MM() {
+
+        if (!running(s2mm) || packets.empty()) {
+            return false;
+        }
+        const std::vector<uint8_t> &packet = packets.front();
+
+        if (!scatter_gather) {
+            if (!s2mm.transfer_pending) {
+                return false;
+            }
+            uint32_t capacity = readRegister(s2mm.length_register) & DMA_LENGTH_REGISTER_MASK;
+            uint8_t *destination = translate(readRegister(s2mm.address_register), capacity);
+            if (destination == nullptr) {
+                fail(s2mm, STATUS_DMA_DECODE_ERR);
+                return true;
+            }
+            if (packet.size() > capacity) {
+                memcpy(destination, packet.data(), capacity);
+                packets.pop_front();
+                fail(s2mm, STATUS_DMA_INTERNAL_ERR); // Packet longer than the buffer
+                return true;
+            }
+            memcpy(destination, packet.data(), packet.size());
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            storeRegister(s2mm.length_register, packet.size()); // Bytes received
+            packets.pop_front();
+            s2mm.transfer_pending = false;
+            raise(s2mm, STATUS_IOC_IRQ | STATUS_IDLE);
+            return true;
+        }
+
+        if (!s2mm.descriptors_pending) {
+            return false;
+        }
+        uint32_t address = s2mm.next_descriptor;
+        volatile SGDescriptor *desc = descriptor(address);
+        if (desc == nullptr) {
+            fail(s2mm, STATUS_SG_DECODE_ERR);
+            return true;
+        }
+        if (desc->status & SG_STATUS_COMPLETE) {
+            fail(s2mm, STATUS_SG_INTERNAL_ERR);
+            return true;
+        }
+        uint32_t capacity = desc->control & SG_CONTROL_LENGTH_MASK;
+        uint8_t *destination = translate(desc->buffer_address, capacity);
+        if (destination == nullptr) {
+            desc->status = SG_STATUS_DECODE_ERR | SG_STATUS_COMPLETE;
+            fail(s2mm, STATUS_DMA_DECODE_ERR);
+            return true;
+        }
+        uint32_t left = packet.size() - packet_offset;
+        uint32_t length = (left < capacity) ? left : capacity;
+        memcpy(destination, packet.data() + packet_offset, length);
+        uint32_t status = length | (packet_offset == 0 ? SG_STATUS_RXSOF : 0);
+        packet_offset += length;
+        if (packet_offset == packet.size()) {
+            status |= SG_STATUS_RXEOF;
+            packets.pop_front();
+            packet_offset = 0;
+        }
+        completeDescriptor(s2mm, address, desc, status);
+        return true;
+
+    }
+
+    void run() {
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            bool progressed = stepMM2S(lock);
+            progressed = stepS2MM() || progressed;
+            if (!progressed && !stopping) {
+                wake.wait(lock);
+            }
+        }
+
+    }
+
+    void unmap() {
+
+        if (memory != MAP_FAILED) {
+            munmap(memory, memory_length);
+        }
+        if (register_map != MAP_FAILED) {
+            munmap(register_map, SIM_REGISTERS_SIZE);
+        }
+
+    }
+
+    void closeFiles() {
+
+        for (int fd : {memory_fd, registers_fd, interrupt_fd}) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+    }
+};
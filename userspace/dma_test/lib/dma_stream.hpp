@@ -0,0 +1,306 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "axi_dma_controller.h"
+#include "reserved_mem.hpp"
+
+#define STREAM_PAGE_SIZE 0x1000
+#define STREAM_WAIT_TIMEOUT_MS 1000
+
+// Streams buffers through the DMA (MM2S -> stream IP -> S2MM) on a ring of count input / output buffer pairs
+// in the reserved memory, so that the producer fills buffer k+1 while the DMA moves buffer k.
+// The producer gets the next free input buffer with acquire(), writes the payload in place and queues it with
+// submit(). Completed output buffers go to the consumer, in submission order, from poll() (or acquire() when
+// every buffer is in flight), then are recycled.
+// With the scatter gather engine every submitted buffer is queued to the DMA at once (descriptor rings), in
+// simple mode the next queued buffer is started as soon as the previous one completes.
+// Not thread safe: the producer and the consumer run on the caller thread.
+class DMAStream {
+public:
+    // Gets an output buffer and the bytes received in it, the buffer must not be written
+    typedef std::function<void(const uint8_t *data, uint32_t length, unsigned int index)> Consumer;
+
+    // offset: start of the stream memory in the reserved memory (bytes, page aligned), the descriptors then the
+    // input and output buffers of buffer_length bytes take up to layoutSize(count, buffer_length) bytes
+    // map_mode: memory type of the buffers (RESERVEDMEM_MAP_*), cached buffers are synced around the transfers
+    // use_interrupts: blocking waits on the UIO interrupt (see AXIDMAController::S2MMWaitForCompletion), spin otherwise
+    DMAStream(AXIDMAController &dma, Reserved_Mem &pmem, uint32_t offset, unsigned int count, uint32_t buffer_length,
+              Consumer consumer, int map_mode = RESERVEDMEM_MAP_WRITECOMBINE, bool use_interrupts = false)
+        : dma(dma), pmem(pmem), consumer(consumer), count(count), buffer_length(buffer_length),
+          stride(alignUp(buffer_length, SG_DESCRIPTOR_ALIGNMENT)), lengths(count, 0),
+          cached(map_mode == RESERVEDMEM_MAP_CACHED), use_interrupts(use_interrupts),
+          fill_index(0), done_index(0), pending(0), acquired(false), started(false), mm2s_done(false), s2mm_done(false) {
+
+        if (offset % STREAM_PAGE_SIZE != 0 || count == 0 || buffer_length == 0 ||
+            buffer_length > DMA_MAX_TRANSFER_LENGTH || offset + layoutSize(count, buffer_length) > MAX_LENGTH) {
+            throw std::string("DMA stream does not fit in the reserved memory");
+        }
+
+        uint32_t descriptors_offset = offset;
+        in_offset = offset + alignUp(2 * count * sizeof(SGDescriptor), STREAM_PAGE_SIZE);
+        out_offset = in_offset + alignUp(count * stride, STREAM_PAGE_SIZE);
+
+        buffers = pmem.map_buffer<uint8_t>(in_offset, out_offset - in_offset + alignUp(count * stride, STREAM_PAGE_SIZE),
+                                           map_mode);
+        // Only the stream memory is mapped (not the whole reserved memory with data()): a write combining alias
+        // of cached buffers would break their coherency
+        descriptors = pmem.map_buffer<uint8_t>(descriptors_offset, in_offset - descriptors_offset,
+                                               RESERVEDMEM_MAP_WRITECOMBINE);
+        if (buffers == nullptr || descriptors == nullptr) {
+            // No destructor for a throwing constructor, the mapping that succeeded is released here
+            pmem.unmap_buffer(buffers);
+            pmem.unmap_buffer(descriptors);
+            throw std::string("DMA stream buffers could not be mapped");
+        }
+
+        scatter_gather = dma.IsScatterGather();
+        if (scatter_gather) {
+            mm2s_ring.reset(new SGRing(descriptors, pmem.physical_address(descriptors_offset), count));
+            s2mm_ring.reset(new SGRing(descriptors + count * sizeof(SGDescriptor),
+                                       pmem.physical_address(descriptors_offset + count * sizeof(SGDescriptor)), count));
+        }
+
+        dma.MM2SReset();
+        dma.S2MMReset();
+
+        dma.MM2SHalt();
+        dma.S2MMHalt();
+
+        dma.MM2SInterruptEnable();
+        dma.S2MMInterruptEnable();
+
+        // In scatter gather mode the channels start on the first descriptors
+        if (!scatter_gather) {
+            dma.MM2SStart();
+            dma.S2MMStart();
+        }
+
+    }
+
+    DMAStream(const DMAStream &) = delete;
+    DMAStream &operator=(const DMAStream &) = delete;
+
+    // Stops the DMA before the buffers and descriptors go back to the caller, pending outputs are dropped
+    ~DMAStream() {
+
+        dma.MM2SReset();
+        dma.S2MMReset();
+        pmem.unmap_buffer(buffers);
+        pmem.unmap_buffer(descriptors);
+
+    }
+
+    // Bytes of reserved memory used by a stream
+    static uint32_t layoutSize(unsigned int count, uint32_t buffer_length) {
+
+        return alignUp(2 * count * sizeof(SGDescriptor), STREAM_PAGE_SIZE) +
+               2 * alignUp(count * alignUp(buffer_length, SG_DESCRIPTOR_ALIGNMENT), STREAM_PAGE_SIZE);
+
+    }
+
+    bool isScatterGather() const {
+
+        return scatter_gather;
+
+    }
+
+    // Buffers submitted and not consumed yet
+    unsigned int inFlight() const {
+
+        return pending;
+
+    }
+
+    // Next free input buffer (buffer_length bytes) to fill in place, the same one until it is submitted
+    // Blocks on the completion of the oldest buffer when all of them are in flight
+    uint8_t *acquire() {
+
+        while (pending == count) {
+            poll(true);
+        }
+        acquired = true;
+
+        return buffers + fill_index * stride;
+
+    }
+
+    // Queues the acquired buffer for length bytes (up to buffer_length), returns false if none is acquired
+    bool submit(uint32_t length) {
+
+        if (!acquired || length == 0 || length > buffer_length) {
+            return false;
+        }
+        unsigned int slot = fill_index;
+        lengths[slot] = length;
+        if (cached) {
+            pmem.sync_for_device(in_offset + slot * stride, length);
+        }
+
+        if (scatter_gather) {
+            s2mm_ring->push(pmem.physical_address(out_offset + slot * stride), buffer_length);
+            mm2s_ring->push(pmem.physical_address(in_offset + slot * stride), length);
+            // S2MM first so that it is ready for the stream
+            if (!started) {
+                dma.S2MMStartSG(*s2mm_ring);
+                dma.MM2SStartSG(*mm2s_ring);
+                started = true;
+            }
+            else {
+                dma.S2MMQueueSG(*s2mm_ring);
+                dma.MM2SQueueSG(*mm2s_ring);
+            }
+        }
+        else if (pending == 0) {
+            startSimple(slot);
+        }
+
+        pending++;
+        fill_index = (fill_index + 1) % count;
+        acquired = false;
+
+        return true;
+
+    }
+
+    // Hands the completed output buffers to the consumer, returns how many
+    // block: waits for at least one if some are in flight, throws on timeout or DMA error
+    unsigned int poll(bool block = false) {
+
+        unsigned int done = 0;
+        for (;;) {
+            while (pending > 0 && completeOldest()) {
+                done++;
+            }
+            if (done > 0 || !block || pending == 0) {
+                return done;
+            }
+            if (use_interrupts) {
+                // A pending MM2S interrupt would keep the shared line up
+                keepFlags(dma.MM2SAcknowledgeInterrupts(), 0);
+                uint32_t s2mm_flags = dma.S2MMWaitForCompletion(STREAM_WAIT_TIMEOUT_MS);
+                if (s2mm_flags == 0) {
+                    throw std::string("DMA stream timed out");
+                }
+                keepFlags(0, s2mm_flags);
+            }
+        }
+
+    }
+
+    // Waits until every submitted buffer is consumed
+    void flush() {
+
+        while (pending > 0) {
+            poll(true);
+        }
+
+    }
+
+private:
+    AXIDMAController &dma;
+    Reserved_Mem &pmem;
+    Consumer consumer;
+    unsigned int count;
+    uint32_t buffer_length;
+    uint32_t stride;                  // Bytes between two buffers
+    std::vector<uint32_t> lengths;    // Submitted length per buffer
+    bool cached;
+    bool use_interrupts;
+    bool scatter_gather;
+    uint32_t in_offset;               // Input buffers in the reserved memory (bytes)
+    uint32_t out_offset;              // Output buffers in the reserved memory (bytes)
+    uint8_t *buffers;                 // Input then output buffers
+    uint8_t *descriptors;             // MM2S then S2MM descriptors
+    std::unique_ptr<SGRing> mm2s_ring;
+    std::unique_ptr<SGRing> s2mm_ring;
+    unsigned int fill_index;          // Buffer returned by acquire()
+    unsigned int done_index;          // Oldest buffer in flight
+    unsigned int pending;             // Buffers in flight
+    bool acquired;
+    bool started;                     // Scatter gather channels running
+    bool mm2s_done;                   // Simple mode: IOC acknowledged for the buffer in flight
+    bool s2mm_done;
+
+    static uint32_t alignUp(uint32_t value, uint32_t alignment) {
+
+        return (value + alignment - 1) / alignment * alignment;
+
+    }
+
+    // Simple mode: one buffer in flight, started as soon as the previous one completes
+    void startSimple(unsigned int slot) {
+
+        dma_barrier(); // Payload written before the DMA reads it
+        dma.S2MMSetDestinationAddress(pmem.physical_address(out_offset + slot * stride));
+        dma.S2MMSetLength(buffer_length);
+        dma.MM2SSetSourceAddress(pmem.physical_address(in_offset + slot * stride));
+        dma.MM2SSetLength(lengths[slot]);
+
+    }
+
+    // Records the acknowledged interrupt flags of the channels, throws on a DMA error
+    // (the error flag is cleared by the acknowledgement, it must not be lost)
+    void keepFlags(uint32_t mm2s_flags, uint32_t s2mm_flags) {
+
+        if ((mm2s_flags | s2mm_flags) & STATUS_ERR_IRQ) {
+            throw std::string("DMA stream transfer error");
+        }
+        mm2s_done = mm2s_done || (mm2s_flags & STATUS_IOC_IRQ);
+        s2mm_done = s2mm_done || (s2mm_flags & STATUS_IOC_IRQ);
+
+    }
+
+    // Consumes the oldest buffer in flight if the DMA completed it
+    bool completeOldest() {
+
+        unsigned int slot = done_index;
+        uint32_t received;
+
+        if (scatter_gather) {
+            if (!mm2s_ring->isComplete(slot) || !s2mm_ring->isComplete(slot)) {
+                return false;
+            }
+            uint32_t mm2s_status = 0;
+            uint32_t s2mm_status = 0;
+            mm2s_ring->pop(mm2s_status);
+            s2mm_ring->pop(s2mm_status);
+            if ((mm2s_status | s2mm_status) & SG_STATUS_ERR) {
+                throw std::string("DMA stream descriptor error");
+            }
+            received = s2mm_status & SG_STATUS_LENGTH_MASK;
+        }
+        else {
+            // Completion from the IOC flags, also the ones acknowledged while waiting in poll()
+            keepFlags(dma.MM2SAcknowledgeInterrupts(), dma.S2MMAcknowledgeInterrupts());
+            if (!mm2s_done || !s2mm_done) {
+                return false;
+            }
+            mm2s_done = false;
+            s2mm_done = false;
+            dma_barrier(); // Output read after the completion
+            received = dma.S2MMGetLength();
+        }
+
+        done_index = (done_index + 1) % count;
+        pending--;
+        // The DMA moves the next buffer while the consumer reads this one
+        if (!scatter_gather && pending > 0) {
+            startSimple(done_index);
+        }
+
+        if (cached) {
+            pmem.sync_for_cpu(out_offset + slot * stride, received);
+        }
+        consumer(buffers + (out_offset - in_offset) + slot * stride, received, slot);
+
+        return true;
+
+    }
+};
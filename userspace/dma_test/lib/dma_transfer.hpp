@@ -0,0 +1,272 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
+
+#include "axi_dma_controller.h"
+
+#define TRANSFER_SEGMENT_ALIGNMENT 0x40 // Segment boundaries, bytes
+#define TRANSFER_WAIT_TIMEOUT_MS 1000
+
+// Result of a DMATransfer run
+struct DMATransferResult {
+    bool ok;                 // False on DMA error or timeout
+    uint64_t mm2s_bytes;
+    uint64_t s2mm_bytes;
+    unsigned int segments;   // MM2S and S2MM segments
+    double seconds;          // From the first start to the last completion
+
+    double mbPerSecond() const {
+
+        return (seconds > 0) ? (double)(mm2s_bytes > s2mm_bytes ? mm2s_bytes : s2mm_bytes) / 1000000. / seconds : 0.;
+
+    }
+};
+
+// Transfers of any length through the DMA, split into segments of at most max_segment bytes (the length
+// registers are limited to DMA_MAX_TRANSFER_LENGTH).
+// With the scatter gather engine, the segments are descriptors of one packet (TLAST only at the end of the last
+// one): the rings are refilled with the next segments as the first ones complete, so the engine always has queued
+// work. In simple mode, each channel starts its next segment as soon as its current one completes, independently
+// of the other channel, but MM2S asserts TLAST at the end of every segment: the stream IP sees one packet per
+// segment. A stream IP changing the length would end each S2MM segment early, so the simple mode only loops back
+// (same MM2S and S2MM lengths), use the scatter gather mode for the other stream IPs.
+class DMATransfer {
+public:
+    // mm2s_ring / s2mm_ring: descriptor rings for the scatter gather mode (both or none), simple mode otherwise
+    // use_interrupts: blocking waits on the UIO interrupt (one for both channels), spin otherwise
+    DMATransfer(AXIDMAController &dma, SGRing *mm2s_ring = nullptr, SGRing *s2mm_ring = nullptr,
+                uint32_t max_segment = DMA_MAX_TRANSFER_LENGTH, bool use_interrupts = false)
+        : dma(dma), mm2s_ring(mm2s_ring), s2mm_ring(s2mm_ring),
+          max_segment(max_segment / TRANSFER_SEGMENT_ALIGNMENT * TRANSFER_SEGMENT_ALIGNMENT),
+          use_interrupts(use_interrupts) {
+
+        if (this->max_segment == 0 || this->max_segment > DMA_MAX_TRANSFER_LENGTH || (mm2s_ring == nullptr) != (s2mm_ring == nullptr)) {
+            throw std::string("Invalid DMA transfer segments or rings");
+        }
+
+    }
+
+    // Streams mm2s_length bytes from the physical address src and receives s2mm_length bytes at dst
+    // (the same length for a loop back, the output size of the stream IP otherwise), blocks until both are done
+    // Throws if the lengths differ in simple mode (loop back only)
+    DMATransferResult run(uint32_t src, uint64_t mm2s_length, uint32_t dst, uint64_t s2mm_length) {
+
+        if (mm2s_ring == nullptr && mm2s_length != s2mm_length) {
+            throw std::string("Simple mode DMA transfers only loop back, the MM2S and S2MM lengths must match");
+        }
+
+        DMATransferResult result = {true, 0, 0, 0, 0.};
+        Channel mm2s = {src, mm2s_length, 0, 0, 0};
+        Channel s2mm = {dst, s2mm_length, 0, 0, 0};
+
+        dma.MM2SReset();
+        dma.S2MMReset();
+
+        dma.MM2SHalt();
+        dma.S2MMHalt();
+
+        dma.MM2SInterruptEnable();
+        dma.S2MMInterruptEnable();
+
+        auto start = std::chrono::steady_clock::now();
+        last_progress = start;
+        if (mm2s_ring != nullptr) {
+            result.ok = runScatterGather(mm2s, s2mm);
+        }
+        else {
+            result.ok = runSimple(mm2s, s2mm);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        result.mm2s_bytes = mm2s.done;
+        result.s2mm_bytes = s2mm.done;
+        result.segments = mm2s.segments + s2mm.segments;
+        result.seconds = elapsed.count();
+
+        return result;
+
+    }
+
+private:
+    struct Channel {
+        uint32_t address;
+        uint64_t length;
+        uint64_t queued;  // Bytes handed to the DMA
+        uint64_t done;    // Bytes completed
+        unsigned int segments;
+    };
+
+    AXIDMAController &dma;
+    SGRing *mm2s_ring;
+    SGRing *s2mm_ring;
+    uint32_t max_segment;
+    bool use_interrupts;
+    std::chrono::steady_clock::time_point last_progress;  // Last completion seen by run()
+
+    uint32_t nextSegment(const Channel &channel) {
+
+        uint64_t left = channel.length - channel.queued;
+        return (left < max_segment) ? (uint32_t)left : max_segment;
+
+    }
+
+    // Waits for the next interrupt when no channel progressed, false on timeout
+    // Spinning, times out once no channel progressed for TRANSFER_WAIT_TIMEOUT_MS (a stalled stream IP or descriptor)
+    bool waitProgress() {
+
+        if (use_interrupts) {
+            return dma.InterruptArm() && dma.InterruptWait(TRANSFER_WAIT_TIMEOUT_MS);
+        }
+        return std::chrono::steady_clock::now() - last_progress < std::chrono::milliseconds(TRANSFER_WAIT_TIMEOUT_MS);
+
+    }
+
+    bool runSimple(Channel &mm2s, Channel &s2mm) {
+
+        dma.MM2SStart();
+        dma.S2MMStart();
+
+        uint32_t mm2s_segment = 0;
+        uint32_t s2mm_segment = 0;
+        // S2MM first so that it is ready for the stream
+        if (s2mm.length > 0) {
+            s2mm_segment = nextSegment(s2mm);
+            startS2MM(s2mm, s2mm_segment);
+        }
+        if (mm2s.length > 0) {
+            mm2s_segment = nextSegment(mm2s);
+            startMM2S(mm2s, mm2s_segment);
+        }
+
+        while (mm2s.done < mm2s.length || s2mm.done < s2mm.length) {
+            uint32_t mm2s_flags = dma.MM2SAcknowledgeInterrupts();
+            uint32_t s2mm_flags = dma.S2MMAcknowledgeInterrupts();
+            if ((mm2s_flags | s2mm_flags) & STATUS_ERR_IRQ) {
+                return false;
+            }
+            if (mm2s_flags & STATUS_IOC_IRQ) {
+                mm2s.done += mm2s_segment;
+                if (mm2s.queued < mm2s.length) {
+                    mm2s_segment = nextSegment(mm2s);
+                    startMM2S(mm2s, mm2s_segment);
+                }
+            }
+            if (s2mm_flags & STATUS_IOC_IRQ) {
+                // Both channels split at the same boundaries: each MM2S packet fills one S2MM segment exactly
+                uint32_t received = dma.S2MMGetLength();
+                s2mm.done += received;
+                if (received != s2mm_segment) {
+                    return false;
+                }
+                if (s2mm.queued < s2mm.length) {
+                    s2mm_segment = nextSegment(s2mm);
+                    startS2MM(s2mm, s2mm_segment);
+                }
+            }
+            if ((mm2s_flags | s2mm_flags) & STATUS_IOC_IRQ) {
+                last_progress = std::chrono::steady_clock::now();
+            }
+            else if (!waitProgress()) {
+                return false;
+            }
+        }
+        return true;
+
+    }
+
+    void startMM2S(Channel &mm2s, uint32_t segment) {
+
+        dma.MM2SSetSourceAddress(mm2s.address + (uint32_t)mm2s.queued);
+        dma.MM2SSetLength(segment);
+        mm2s.queued += segment;
+        mm2s.segments++;
+
+    }
+
+    void startS2MM(Channel &s2mm, uint32_t segment) {
+
+        dma.S2MMSetDestinationAddress(s2mm.address + (uint32_t)s2mm.queued);
+        dma.S2MMSetLength(segment);
+        s2mm.queued += segment;
+        s2mm.segments++;
+
+    }
+
+    // Pushes the next segments while the ring has room, true if any was pushed
+    bool refill(SGRing &ring, Channel &channel, bool mm2s) {
+
+        bool pushed = false;
+        while (!ring.full() && channel.queued < channel.length) {
+            uint32_t segment = nextSegment(channel);
+            // One packet: start of frame on the first segment, end of frame on the last one
+            ring.push(channel.address + (uint32_t)channel.queued, segment,
+                      mm2s && channel.queued == 0, mm2s && channel.queued + segment == channel.length);
+            channel.queued += segment;
+            channel.segments++;
+            pushed = true;
+        }
+        return pushed;
+
+    }
+
+    // Pops the completed segments, false on a descriptor error
+    // An S2MM descriptor with RXEOF ends the packet, the stream IP output can be shorter than the S2MM length
+    bool reap(SGRing &ring, Channel &channel, bool &progressed) {
+
+        uint32_t status;
+        while (ring.pop(status) >= 0) {
+            if (status & SG_STATUS_ERR) {
+                return false;
+            }
+            channel.done += status & SG_STATUS_LENGTH_MASK;
+            if (status & SG_STATUS_RXEOF) {
+                channel.length = channel.done;
+            }
+            progressed = true;
+        }
+        return true;
+
+    }
+
+    bool runScatterGather(Channel &mm2s, Channel &s2mm) {
+
+        // The channels were reset, descriptors left by a short packet of the previous run are dropped
+        mm2s_ring->reset();
+        s2mm_ring->reset();
+
+        if (refill(*s2mm_ring, s2mm, false)) {
+            dma.S2MMStartSG(*s2mm_ring);
+        }
+        if (refill(*mm2s_ring, mm2s, true)) {
+            dma.MM2SStartSG(*mm2s_ring);
+        }
+
+        while (mm2s.done < mm2s.length || s2mm.done < s2mm.length) {
+            // Acknowledged before looking at the descriptors, a later completion raises the interrupt again
+            dma.MM2SAcknowledgeInterrupts();
+            dma.S2MMAcknowledgeInterrupts();
+
+            bool progressed = false;
+            if (!reap(*mm2s_ring, mm2s, progressed) || !reap(*s2mm_ring, s2mm, progressed)) {
+                return false;
+            }
+            if (refill(*mm2s_ring, mm2s, true)) {
+                dma.MM2SQueueSG(*mm2s_ring);
+            }
+            if (refill(*s2mm_ring, s2mm, false)) {
+                dma.S2MMQueueSG(*s2mm_ring);
+            }
+            if (progressed) {
+                last_progress = std::chrono::steady_clock::now();
+            }
+            else if (!waitProgress()) {
+                return false;
+            }
+        }
+        return true;
+
+    }
+};
@@ -0,0 +1,357 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "reserved_mem.hpp"
+
+#define ALLOCATOR_PAGE_SIZE 0x1000       // Buddy block of order 0, slab of the size classes
+#define ALLOCATOR_MIN_CLASS 64           // Smallest size class, DMA and cache line alignment
+#define ALLOCATOR_CLASS_COUNT 6          // Size classes 64 to 2048 bytes
+#define ALLOCATOR_MAX_ORDER 16           // Blocks of up to 2^16 pages (256 MiB)
+
+// Buffer of the reserved memory, as seen by the CPU and by the DMA
+struct DMABuffer {
+    uint8_t *data;      // User space pointer, nullptr if the allocation failed
+    uint32_t physical;  // Address to give to the DMA
+    uint32_t offset;    // Offset in the reserved memory (bytes), for Reserved_Mem::sync_for_device / sync_for_cpu
+                        // (only needed on a cached region)
+    uint32_t size;      // Usable bytes, the request rounded up
+
+    explicit operator bool() const { return data != nullptr; }
+};
+
+// Allocator of DMA buffers over (a part of) the reserved memory, so that several pipelines can keep buffers in
+// flight without managing the layout by hand.
+// Requests up to 2048 bytes come from size class pools (64, 128... 2048 bytes), each carving pages into equal
+// slots; bigger ones from a buddy allocator of pages, which also provides the pool pages and gets them back once
+// empty. Buffers are aligned on their size class, or on a page for the buddy blocks (the region starts on a page).
+// The buffers have the memory type the region is mapped with: write combining by default, cached regions need
+// Reserved_Mem::sync_for_device / sync_for_cpu around the transfers. The region must not be mapped with another
+// type at the same time (no Reserved_Mem::data() on it): mismatched aliases break the coherency.
+// Thread safe.
+class ReservedMemAllocator {
+public:
+    struct Stats {
+        uint32_t free_bytes;         // Free pages (buddy), the free slots of the pools are not counted
+        uint32_t largest_free_block; // Biggest buffer that can be allocated (bytes)
+        uint32_t allocated_buffers;
+        double fragmentation;        // 1 - largest_free_block / free_bytes
+    };
+
+    // length bytes of the reserved memory from offset (bytes, page aligned), 0: up to the end of the reserved
+    // memory. The region is mapped with map_mode (RESERVEDMEM_MAP_*) until the destruction.
+    explicit ReservedMemAllocator(Reserved_Mem &pmem, uint32_t offset = 0, uint32_t length = 0,
+                                  int map_mode = RESERVEDMEM_MAP_WRITECOMBINE)
+        : ReservedMemAllocator(mapRegion(pmem, offset, length, map_mode), pmem.physical_address(offset), offset,
+                               regionLength(offset, length)) {
+
+        mapped_by = &pmem;
+
+    }
+
+    // Any memory region: base is its user space pointer, physical_base its DMA address and base_offset its
+    // offset in the reserved memory (both page aligned), length is rounded down to pages
+    ReservedMemAllocator(uint8_t *base, uint32_t physical_base, uint32_t base_offset, uint32_t length)
+        : base(base), physical_base(physical_base), base_offset(base_offset),
+          page_count(length / ALLOCATOR_PAGE_SIZE), pages(page_count), allocated_buffers(0), mapped_by(nullptr) {
+
+        if (base == nullptr || page_count == 0) {
+            throw std::string("Reserved memory allocator needs a mapped region of at least a page");
+        }
+        if (physical_base % ALLOCATOR_PAGE_SIZE != 0 || base_offset % ALLOCATOR_PAGE_SIZE != 0) {
+            throw std::string("Reserved memory allocator region must start on a page");
+        }
+        for (int order = 0; order <= ALLOCATOR_MAX_ORDER; order++) {
+            free_heads[order] = -1;
+        }
+        for (int c = 0; c < ALLOCATOR_CLASS_COUNT; c++) {
+            partial_heads[c] = -1;
+        }
+
+        // Largest aligned blocks covering the region
+        uint32_t page = 0;
+        while (page < page_count) {
+            int order = 0;
+            while (order < ALLOCATOR_MAX_ORDER && page % (2u << order) == 0 && page + (2u << order) <= page_count) {
+                order++;
+            }
+            pushFree(page, order);
+            page += 1u << order;
+        }
+    }
+
+    ReservedMemAllocator(const ReservedMemAllocator &) = delete;
+    ReservedMemAllocator &operator=(const ReservedMemAllocator &) = delete;
+
+    // The buffers must not be used anymore, the region mapped by the allocator is unmapped
+    ~ReservedMemAllocator() {
+
+        if (mapped_by != nullptr) {
+            mapped_by->unmap_buffer(base);
+        }
+
+    }
+
+    // Returns a buffer of at least size bytes, data is nullptr if there is no room
+    DMABuffer allocate(uint32_t size) {
+
+        std::lock_guard<std::mutex> lock(mutex);
+        DMABuffer buffer = {nullptr, 0, 0, 0};
+        if (size == 0) {
+            return buffer;
+        }
+
+        int size_class = sizeClass(size);
+        if (size_class >= 0) {
+            int32_t page = partial_heads[size_class];
+            if (page < 0) {
+                page = allocatePages(0);
+                if (page < 0) {
+                    return buffer;
+                }
+                pages[page].slab_class = size_class;
+                pages[page].slab_free = fullSlabMask(size_class);
+                pushPartial(page, size_class);
+            }
+            PageInfo &info = pages[page];
+            int slot = __builtin_ctzll(info.slab_free);
+            info.slab_free &= ~(1ull << slot);
+            if (info.slab_free == 0) {
+                removeList(page, partial_heads[size_class]);
+            }
+            buffer = makeBuffer(page * ALLOCATOR_PAGE_SIZE + slot * classSize(size_class), classSize(size_class));
+        }
+        else {
+            int order = 0;
+            while (((uint64_t)ALLOCATOR_PAGE_SIZE << order) < size) {
+                order++;
+            }
+            int32_t page = allocatePages(order);
+            if (page < 0) {
+                return buffer;
+            }
+            pages[page].alloc_order = order;
+            buffer = makeBuffer(page * ALLOCATOR_PAGE_SIZE, ALLOCATOR_PAGE_SIZE << order);
+        }
+        allocated_buffers++;
+
+        return buffer;
+
+    }
+
+    // Gives a buffer of allocate() back, ignores empty buffers
+    void free(const DMABuffer &buffer) {
+
+        if (!buffer) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t relative = buffer.offset - base_offset;
+        int32_t page = relative / ALLOCATOR_PAGE_SIZE;
+        PageInfo &info = pages[page];
+
+        if (info.slab_class >= 0) {
+            int size_class = info.slab_class;
+            bool was_full = info.slab_free == 0;
+            info.slab_free |= 1ull << ((relative % ALLOCATOR_PAGE_SIZE) / classSize(size_class));
+            if (info.slab_free == fullSlabMask(size_class)) {
+                // Empty slab back to the buddy allocator
+                if (!was_full) {
+                    removeList(page, partial_heads[size_class]);
+                }
+                info.slab_class = -1;
+                freePages(page, 0);
+            }
+            else if (was_full) {
+                pushPartial(page, size_class);
+            }
+        }
+        else {
+            int order = info.alloc_order;
+            info.alloc_order = -1;
+            freePages(page, order);
+        }
+        allocated_buffers--;
+
+    }
+
+    Stats stats() {
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats s = {0, 0, allocated_buffers, 0};
+        for (int order = 0; order <= ALLOCATOR_MAX_ORDER; order++) {
+            for (int32_t page = free_heads[order]; page >= 0; page = pages[page].next) {
+                s.free_bytes += ALLOCATOR_PAGE_SIZE << order;
+                s.largest_free_block = ALLOCATOR_PAGE_SIZE << order;
+            }
+        }
+        s.fragmentation = (s.free_bytes > 0) ? 1. - (double)s.largest_free_block / s.free_bytes : 0.;
+        return s;
+
+    }
+
+private:
+    // Per page: head of a free buddy block, of an allocated buddy block or slab of a size class
+    struct PageInfo {
+        int8_t free_order = -1;   // Free block starting here
+        int8_t alloc_order = -1;  // Allocated block starting here
+        int8_t slab_class = -1;   // Page carved by a size class pool
+        uint64_t slab_free = 0;   // Free slots of the slab
+        int32_t next = -1;        // Free list of the order or partial slab list of the class
+        int32_t prev = -1;
+    };
+
+    uint8_t *base;
+    uint32_t physical_base;
+    uint32_t base_offset;
+    uint32_t page_count;
+    std::vector<PageInfo> pages;
+    int32_t free_heads[ALLOCATOR_MAX_ORDER + 1];     // Free blocks per order
+    int32_t partial_heads[ALLOCATOR_CLASS_COUNT];    // Slabs with free slots per class
+    uint32_t allocated_buffers;
+    Reserved_Mem *mapped_by;  // Owner of the mapping of the region, nullptr for a region given by the caller
+    std::mutex mutex;
+
+    // Length of the region of the reserved memory, rounded down to pages (0: up to the end)
+    static uint32_t regionLength(uint32_t offset, uint32_t length) {
+
+        if (offset >= MAX_LENGTH) {
+            return 0;
+        }
+        if (length == 0) {
+            length = MAX_LENGTH - offset;
+        }
+        return length / ALLOCATOR_PAGE_SIZE * ALLOCATOR_PAGE_SIZE;
+
+    }
+
+    static uint8_t *mapRegion(Reserved_Mem &pmem, uint32_t offset, uint32_t length, int map_mode) {
+
+        uint32_t region_length = regionLength(offset, length);
+        if (offset % ALLOCATOR_PAGE_SIZE != 0 || region_length == 0 || region_length > MAX_LENGTH - offset) {
+            throw std::string("Reserved memory allocator region is not page aligned or not in the reserved memory");
+        }
+        uint8_t *region = pmem.map_buffer<uint8_t>(offset, region_length, map_mode);
+        if (region == nullptr) {
+            throw std::string("Reserved memory allocator region could not be mapped");
+        }
+        return region;
+
+    }
+
+    static uint32_t classSize(int size_class) {
+
+        return ALLOCATOR_MIN_CLASS << size_class;
+
+    }
+
+    static int sizeClass(uint32_t size) {
+
+        for (int c = 0; c < ALLOCATOR_CLASS_COUNT; c++) {
+            if (size <= classSize(c)) {
+                return c;
+            }
+        }
+        return -1;
+
+    }
+
+    static uint64_t fullSlabMask(int size_class) {
+
+        uint32_t slots = ALLOCATOR_PAGE_SIZE / classSize(size_class);
+        return (slots >= 64) ? ~0ull : (1ull << slots) - 1;
+
+    }
+
+    DMABuffer makeBuffer(uint32_t relative, uint32_t size) {
+
+        DMABuffer buffer = {base + relative, physical_base + relative, base_offset + relative, size};
+        return buffer;
+
+    }
+
+    void pushList(int32_t page, int32_t &head) {
+
+        pages[page].prev = -1;
+        pages[page].next = head;
+        if (head >= 0) {
+            pages[head].prev = page;
+        }
+        head = page;
+
+    }
+
+    void removeList(int32_t page, int32_t &head) {
+
+        PageInfo &info = pages[page];
+        if (info.prev >= 0) {
+            pages[info.prev].next = info.next;
+        }
+        else {
+            head = info.next;
+        }
+        if (info.next >= 0) {
+            pages[info.next].prev = info.prev;
+        }
+        info.next = -1;
+        info.prev = -1;
+
+    }
+
+    void pushFree(int32_t page, int order) {
+
+        pages[page].free_order = order;
+        pushList(page, free_heads[order]);
+
+    }
+
+    void pushPartial(int32_t page, int size_class) {
+
+        pushList(page, partial_heads[size_class]);
+
+    }
+
+    // First page of a free block of 2^order pages, split from a bigger one if needed, -1 if none
+    int32_t allocatePages(int order) {
+
+        int found = order;
+        while (found <= ALLOCATOR_MAX_ORDER && free_heads[found] < 0) {
+            found++;
+        }
+        if (found > ALLOCATOR_MAX_ORDER) {
+            return -1;
+        }
+
+        int32_t page = free_heads[found];
+        removeList(page, free_heads[found]);
+        pages[page].free_order = -1;
+        // Upper halves back to the free lists
+        while (found > order) {
+            found--;
+            pushFree(page + (1 << found), found);
+        }
+        return page;
+
+    }
+
+    // Frees a block of 2^order pages, merged with its free buddies
+    void freePages(int32_t page, int order) {
+
+        while (order < ALLOCATOR_MAX_ORDER) {
+            uint32_t buddy = page ^ (1u << order);
+            if (buddy >= page_count || pages[buddy].free_order != order) {
+                break;
+            }
+            removeList(buddy, free_heads[order]);
+            pages[buddy].free_order = -1;
+            page = (page < (int32_t)buddy) ? page : buddy;
+            order++;
+        }
+        pushFree(page, order);
+
+    }
+};
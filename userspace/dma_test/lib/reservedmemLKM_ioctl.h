@@ -0,0 +1 @@
+ReservedMemory-LKM-and-UserSpaceAPI/reservedmemLKM_ioctl.h
\ No newline at end of file
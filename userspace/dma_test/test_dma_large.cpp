@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <iostream>
+#include <memory>
+
+#include "axi_dma_controller.h"
+#include "axi_dma_sim.hpp"
+#include "dma_transfer.hpp"
+#include "reserved_mem.hpp"
+
+#define DATA_LENGTH (MAX_LENGTH / 2 - DESC_LENGTH) // Bytes, input and output both fit in the reserved memory
+#define DESC_LENGTH 0x1000 // Bytes of descriptors per channel
+#define RING_SIZE 32 // Descriptors per channel
+#define MM2S_DESC_OFFSET 0 // Offsets in the reserved memory (in bytes)
+#define S2MM_DESC_OFFSET (MAX_LENGTH / 2)
+#define I_OFFSET (MM2S_DESC_OFFSET + DESC_LENGTH)
+#define O_OFFSET (S2MM_DESC_OFFSET + DESC_LENGTH)
+
+#define UIO_DMA_N 0
+
+/**
+ * Test of the transfers longer than the DMA length registers
+ *
+ * Loops back DATA_LENGTH bytes (about 8 MiB) in one DMATransfer::run, split in segments of the maximum length
+ * (one segment: input and output together cannot exceed the 16 MiB of reserved memory, a bigger region is split
+ * the same way), then of 4 MiB down to 64 KiB to show the cost of each segment, in the mode the DMA is built
+ * with (simple or scatter gather). Prints the effective bandwidth and checks the output.
+ *
+ * With -s, runs on the DMA simulator in simple mode, -g in scatter gather mode (no board needed).
+ *
+ * Needs the LKM to be loaded (see test_dma.cpp), build with:
+ * ```
+ * g++ -O2 -std=c++11 -Ilib test_dma_large.cpp -o test_dma_large
+ * ```
+ */
+int main(int argc, char **argv)
+{
+	printf("Running DMA large transfer test application with specified memory.\n\n");
+
+	std::unique_ptr<AXIDMASim> sim;
+	int option;
+	while ((option = getopt(argc, argv, "sg")) != -1)
+	{
+		if (option != 's' && option != 'g')
+		{
+			printf("Usage: %s [-s | -g]\n", argv[0]);
+			return -1;
+		}
+		sim.reset(new AXIDMASim(option == 'g'));
+	}
+
+	std::unique_ptr<Reserved_Mem> pmem_ptr(sim ? new Reserved_Mem(sim->memoryFileDescriptor()) : new Reserved_Mem());
+	std::unique_ptr<AXIDMAController> dma_ptr(sim ?
+		new AXIDMAController(sim->registers(), sim->writeHook(), sim->interruptFileDescriptor()) :
+		new AXIDMAController(UIO_DMA_N, 0x10000));
+	Reserved_Mem &pmem = *pmem_ptr;
+	AXIDMAController &dma = *dma_ptr;
+
+	uint32_t *i_buff = pmem.data<uint32_t>(I_OFFSET);
+	uint32_t *o_buff = pmem.data<uint32_t>(O_OFFSET);
+	if (i_buff == nullptr || o_buff == nullptr)
+	{
+		printf("Could not map %s\n", DEVICE_FILENAME);
+		return -1;
+	}
+	for (unsigned int i = 0; i < DATA_LENGTH / sizeof(uint32_t); i++)
+	{
+		i_buff[i] = i;
+	}
+
+	SGRing mm2s_ring(pmem.data<void>(MM2S_DESC_OFFSET), pmem.physical_address(MM2S_DESC_OFFSET), RING_SIZE);
+	SGRing s2mm_ring(pmem.data<void>(S2MM_DESC_OFFSET), pmem.physical_address(S2MM_DESC_OFFSET), RING_SIZE);
+	bool scatter_gather = dma.IsScatterGather();
+
+	const uint32_t segments[] = {DMA_MAX_TRANSFER_LENGTH, 1 << 22, 1 << 20, 1 << 16};
+	for (uint32_t segment : segments)
+	{
+		memset(o_buff, 0, DATA_LENGTH);
+
+		DMATransfer transfer(dma, scatter_gather ? &mm2s_ring : nullptr,
+			scatter_gather ? &s2mm_ring : nullptr, segment);
+		DMATransferResult result = transfer.run(pmem.physical_address(I_OFFSET), DATA_LENGTH,
+			pmem.physical_address(O_OFFSET), DATA_LENGTH);
+
+		bool same = memcmp(i_buff, o_buff, DATA_LENGTH) == 0;
+		printf("%s, segments of %u bytes: %u segments, %fms, %.1f MB/s%s\n", scatter_gather ? "scatter gather" : "simple",
+			segment, result.segments, result.seconds * 1000, result.mbPerSecond(),
+			result.ok && same ? "" : " FAILED");
+		if (!result.ok || !same || result.s2mm_bytes != DATA_LENGTH)
+		{
+			return -1;
+		}
+	}
+
+	printf("\nDMA LARGE TRANSFERT ENDED!\n");
+
+	return 0;
+}
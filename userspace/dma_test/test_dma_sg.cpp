@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+
+#include <chrono>
+
+#include "axi_dma_controller.h"
+#include "reserved_mem.hpp"
+
+#define BUFFER_COUNT 16 // Buffers chained in one start
+#define BUFFER_LENGTH 4096 // Bytes
+#define MM2S_DESC_OFFSET 0x0000 // Offsets in the reserved memory (in bytes)
+#define S2MM_DESC_OFFSET 0x1000
+#define I_OFFSET 0x10000
+#define O_OFFSET 0x100000
+
+#define UIO_DMA_N 0
+
+bool has_error(DMAStatus &status)
+{
+	for (dma_status s : status)
+	{
+		if (s == DMA_INTERNAL_ERR || s == DMA_SLAVE_ERR || s == DMA_DECODE_ERR ||
+			s == DMA_SG_INTERNAL_ERR || s == DMA_SG_SLAVE_ERR || s == DMA_SG_DECODE_ERR)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Test of the DMA in scatter gather mode
+ *
+ * Queues BUFFER_COUNT buffers of the reserved memory on both channels at once (descriptor rings in the reserved
+ * memory too), then prints the completion of every descriptor and checks the looped back data.
+ * The DMA must be built with the scatter gather engine, with MM2S looped back to S2MM.
+ *
+ * Needs the LKM to be loaded (see test_dma.cpp), build with:
+ * ```
+ * g++ -O2 -std=c++11 -Ilib test_dma_sg.cpp -o test_dma_sg
+ * ```
+ */
+int main()
+{
+	printf("Running DMA scatter gather test application with specified memory.\n\n");
+
+	Reserved_Mem pmem;
+	AXIDMAController dma(UIO_DMA_N, 0x10000);
+
+	if (!dma.IsScatterGather())
+	{
+		printf("The DMA is built without the scatter gather engine\n");
+		return -1;
+	}
+
+	uint32_t *i_buff = pmem.data<uint32_t>(I_OFFSET);
+	uint32_t *o_buff = pmem.data<uint32_t>(O_OFFSET);
+	if (i_buff == nullptr || o_buff == nullptr)
+	{
+		printf("Could not map %s\n", DEVICE_FILENAME);
+		return -1;
+	}
+
+	SGRing mm2s_ring(pmem.data<void>(MM2S_DESC_OFFSET), pmem.physical_address(MM2S_DESC_OFFSET), BUFFER_COUNT);
+	SGRing s2mm_ring(pmem.data<void>(S2MM_DESC_OFFSET), pmem.physical_address(S2MM_DESC_OFFSET), BUFFER_COUNT);
+
+	// Payloads written in place
+	for (unsigned int i = 0; i < BUFFER_COUNT * BUFFER_LENGTH / sizeof(uint32_t); i++)
+	{
+		i_buff[i] = i;
+		o_buff[i] = 0;
+	}
+
+	for (int b = 0; b < BUFFER_COUNT; b++)
+	{
+		mm2s_ring.push(pmem.physical_address(I_OFFSET + b * BUFFER_LENGTH), BUFFER_LENGTH);
+		s2mm_ring.push(pmem.physical_address(O_OFFSET + b * BUFFER_LENGTH), BUFFER_LENGTH);
+	}
+
+	auto t1 = std::chrono::steady_clock::now();
+
+	dma.MM2SReset();
+	dma.S2MMReset();
+
+	dma.MM2SHalt();
+	dma.S2MMHalt();
+
+	// S2MM first so that it is ready for the stream
+	dma.S2MMStartSG(s2mm_ring);
+	dma.MM2SStartSG(mm2s_ring);
+
+	int mm2s_done = 0;
+	int s2mm_done = 0;
+	uint32_t status;
+	while (mm2s_done < BUFFER_COUNT || s2mm_done < BUFFER_COUNT)
+	{
+		int index;
+		while ((index = mm2s_ring.pop(status)) >= 0)
+		{
+			printf("MM2S descriptor %2d complete: %u bytes%s\n", index, status & SG_STATUS_LENGTH_MASK,
+				(status & SG_STATUS_ERR) ? " ERROR" : "");
+			mm2s_done++;
+		}
+		while ((index = s2mm_ring.pop(status)) >= 0)
+		{
+			printf("S2MM descriptor %2d complete: %u bytes%s%s\n", index, status & SG_STATUS_LENGTH_MASK,
+				(status & SG_STATUS_RXEOF) ? " EOF" : "", (status & SG_STATUS_ERR) ? " ERROR" : "");
+			s2mm_done++;
+		}
+
+		DMAStatus mm2s_status = dma.MM2SGetStatus();
+		DMAStatus s2mm_status = dma.S2MMGetStatus();
+		if (has_error(mm2s_status) || has_error(s2mm_status))
+		{
+			printf("MM2S status: %s\nS2MM status: %s\n", mm2s_status.to_string().c_str(), s2mm_status.to_string().c_str());
+			return -1;
+		}
+	}
+
+	std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - t1;
+	printf("\n%d MM2S and %d S2MM descriptors completed in %fms [%fMB]\n", mm2s_done, s2mm_done, ms.count(),
+		(float)BUFFER_COUNT * BUFFER_LENGTH / 1000000.);
+
+	if (memcmp(i_buff, o_buff, BUFFER_COUNT * BUFFER_LENGTH) != 0)
+	{
+		printf("Output buffers differ from the input ones\n");
+		return -1;
+	}
+	printf("DMA SCATTER GATHER TRANSFERT ENDED!\n");
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <iostream>
+#include <memory>
+
+#include <chrono>
+
+#include "axi_dma_controller.h"
+#include "axi_dma_sim.hpp"
+#include "dma_stream.hpp"
+#include "reserved_mem.hpp"
+
+#define FRAME_COUNT 256 // Buffers streamed per run
+#define FRAME_LENGTH 0x10000 // Bytes
+#define STREAM_OFFSET 0 // Offset in the reserved memory of the stream buffers (in bytes)
+
+#define UIO_DMA_N 0
+
+/**
+ * Test of the streaming DMA pipeline
+ *
+ * Streams FRAME_COUNT buffers (MM2S looped back to S2MM) through rings of 1 (one transfer at a time, like
+ * test_dma.cpp), 2 (ping-pong), 4 and 8 buffers, checks every output buffer and prints the sustained throughput.
+ *
+ * With -s, runs on the DMA simulator in simple mode, -g in scatter gather mode (no board needed).
+ *
+ * Needs the LKM to be loaded (see test_dma.cpp), build with:
+ * ```
+ * g++ -O2 -std=c++11 -Ilib test_dma_stream.cpp -o test_dma_stream
+ * ```
+ */
+int main(int argc, char **argv)
+{
+	printf("Running DMA streaming test application with specified memory.\n\n");
+
+	std::unique_ptr<AXIDMASim> sim;
+	int option;
+	while ((option = getopt(argc, argv, "sg")) != -1)
+	{
+		if (option != 's' && option != 'g')
+		{
+			printf("Usage: %s [-s | -g]\n", argv[0]);
+			return -1;
+		}
+		sim.reset(new AXIDMASim(option == 'g'));
+	}
+
+	std::unique_ptr<Reserved_Mem> pmem_ptr(sim ? new Reserved_Mem(sim->memoryFileDescriptor()) : new Reserved_Mem());
+	std::unique_ptr<AXIDMAController> dma_ptr(sim ?
+		new AXIDMAController(sim->registers(), sim->writeHook(), sim->interruptFileDescriptor()) :
+		new AXIDMAController(UIO_DMA_N, 0x10000));
+	Reserved_Mem &pmem = *pmem_ptr;
+	AXIDMAController &dma = *dma_ptr;
+
+	const unsigned int ring_sizes[] = {1, 2, 4, 8};
+	for (unsigned int ring_size : ring_sizes)
+	{
+		int consumed = 0;
+		int errors = 0;
+		DMAStream stream(dma, pmem, STREAM_OFFSET, ring_size, FRAME_LENGTH,
+			[&](const uint8_t *data, uint32_t length, unsigned int index)
+			{
+				const uint32_t *words = (const uint32_t *)data;
+				if (length != FRAME_LENGTH || words[0] != (uint32_t)consumed ||
+					words[FRAME_LENGTH / sizeof(uint32_t) - 1] != (uint32_t)consumed)
+				{
+					errors++;
+				}
+				consumed++;
+			});
+
+		auto t1 = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < FRAME_COUNT; frame++)
+		{
+			uint32_t *words = (uint32_t *)stream.acquire();
+			for (unsigned int i = 0; i < FRAME_LENGTH / sizeof(uint32_t); i++)
+			{
+				words[i] = frame;
+			}
+			stream.submit(FRAME_LENGTH);
+			stream.poll();
+		}
+		stream.flush();
+		std::chrono::duration<double> s = std::chrono::steady_clock::now() - t1;
+
+		printf("%u buffer(s)%s: %d frames in %fms, %.1f MB/s, %d error(s)\n", ring_size,
+			stream.isScatterGather() ? " (scatter gather)" : "", consumed, s.count() * 1000,
+			(double)FRAME_COUNT * FRAME_LENGTH / 1000000. / s.count(), errors);
+		if (errors != 0 || consumed != FRAME_COUNT)
+		{
+			return -1;
+		}
+	}
+
+	printf("\nDMA STREAMING ENDED!\n");
+
+	return 0;
+}
@@ -22,6 +22,7 @@
 #include "rclcpp/rclcpp.hpp"
 #include "rcutils/cmdline_parser.h"
 #include "dynamixel_sdk/dynamixel_sdk.h"
+#include "dynamixel_sdk_custom_interfaces/msg/motor_write_ack.hpp"
 #include "dynamixel_sdk_custom_interfaces/msg/set_position.hpp"
 #include "dynamixel_sdk_custom_interfaces/srv/get_position.hpp"
 
@@ -30,6 +31,7 @@ class ReadWriteNode : public rclcpp::Node
 {
 public:
   using SetPosition = dynamixel_sdk_custom_interfaces::msg::SetPosition;
+  using MotorWriteAck = dynamixel_sdk_custom_interfaces::msg::MotorWriteAck;
   using GetPosition = dynamixel_sdk_custom_interfaces::srv::GetPosition;
 
   ReadWriteNode();
@@ -38,6 +40,7 @@ public:
 private:
   rclcpp::Subscription<SetPosition>::SharedPtr set_position_subscriber_;
   rclcpp::Service<GetPosition>::SharedPtr get_position_server_;
+  rclcpp::Publisher<MotorWriteAck>::SharedPtr motor_write_ack_publisher_;
 
   int present_position;
 };
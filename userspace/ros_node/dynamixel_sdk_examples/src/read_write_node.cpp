@@ -32,6 +32,7 @@
 #include <string>
 
 #include "dynamixel_sdk/dynamixel_sdk.h"
+#include "dynamixel_sdk_custom_interfaces/msg/motor_write_ack.hpp"
 #include "dynamixel_sdk_custom_interfaces/msg/set_position.hpp"
 #include "dynamixel_sdk_custom_interfaces/srv/get_position.hpp"
 #include "rclcpp/rclcpp.hpp"
@@ -71,12 +72,16 @@ ReadWriteNode::ReadWriteNode()
   const auto QOS_RKL10V =
     rclcpp::QoS(rclcpp::KeepLast(qos_depth)).reliable().durability_volatile();
 
+  // Completion of every goal position write, for the latency traces of the commanding node
+  motor_write_ack_publisher_ = this->create_publisher<MotorWriteAck>("motor_write_ack", QOS_RKL10V);
+
   set_position_subscriber_ =
     this->create_subscription<SetPosition>(
     "set_position",
     QOS_RKL10V,
     [this](const SetPosition::SharedPtr msg) -> void
     {
+      rclcpp::Time received = this->now();
       uint8_t dxl_error = 0;
 
       // Position Value of X series is 4 byte data.
@@ -94,6 +99,16 @@ ReadWriteNode::ReadWriteNode()
         &dxl_error
       );
 
+      MotorWriteAck ack;
+      ack.id = msg->id;
+      ack.position = msg->position;
+      ack.trace_id = msg->trace_id;
+      ack.received = received;
+      ack.written = this->now();
+      ack.comm_result = dxl_comm_result;
+      ack.dxl_error = dxl_error;
+      motor_write_ack_publisher_->publish(ack);
+
       if (dxl_comm_result != COMM_SUCCESS) {
         RCLCPP_INFO(this->get_logger(), "%s", packetHandler->getTxRxResult(dxl_comm_result));
       } else if (dxl_error != 0) {
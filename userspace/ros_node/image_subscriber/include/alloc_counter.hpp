@@ -0,0 +1,44 @@
+#ifndef ALLOC_COUNTER_HPP_
+#define ALLOC_COUNTER_HPP_
+
+#include <cstdint>
+
+// Heap allocation counter of debug builds (ALLOC_COUNTER defined, see CMakeLists.txt).
+// malloc() and its variants are replaced to count the allocations made by the calling thread while an
+// AllocationScope is alive. Without ALLOC_COUNTER the scopes are free and always count 0.
+#ifdef ALLOC_COUNTER
+#define ALLOC_COUNTER_ENABLED true
+uint64_t alloc_counter_begin();
+uint64_t alloc_counter_end(uint64_t begin_count);
+#else
+#define ALLOC_COUNTER_ENABLED false
+inline uint64_t alloc_counter_begin() { return 0; }
+inline uint64_t alloc_counter_end(uint64_t) { return 0; }
+#endif
+
+class AllocationScope
+{
+    public:
+        AllocationScope() : begin_count(alloc_counter_begin()), allocations(0), ended(false) {}
+        ~AllocationScope() { end(); }
+
+        AllocationScope(const AllocationScope&) = delete;
+        AllocationScope& operator=(const AllocationScope&) = delete;
+
+        // Stops counting, returns the allocations made since the construction
+        uint64_t end()
+        {
+            if (!ended) {
+                allocations = alloc_counter_end(begin_count);
+                ended = true;
+            }
+            return allocations;
+        }
+
+    private:
+        uint64_t begin_count;
+        uint64_t allocations;
+        bool ended;
+};
+
+#endif  // ALLOC_COUNTER_HPP_
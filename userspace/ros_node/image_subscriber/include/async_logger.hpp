@@ -0,0 +1,78 @@
+#ifndef ASYNC_LOGGER_HPP_
+#define ASYNC_LOGGER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <rclcpp/rclcpp.hpp>
+
+#define ASYNC_LOG_LEVEL_DEBUG 0
+#define ASYNC_LOG_LEVEL_INFO 1
+#define ASYNC_LOG_LEVEL_WARN 2
+#define ASYNC_LOG_LEVEL_ERROR 3
+
+// Records below this level are compiled out (set from CMake with -DASYNC_LOG_LEVEL=<level>)
+#ifndef ASYNC_LOG_LEVEL
+#define ASYNC_LOG_LEVEL ASYNC_LOG_LEVEL_INFO
+#endif
+
+#define ASYNC_LOG_RING_SIZE 1024   // Records, must be a power of 2
+#define ASYNC_LOG_RECORD_LENGTH 240 // Bytes of formatted text per record
+#define ASYNC_LOG_DRAIN_PERIOD_MS 5 // Sleep of the drain thread when the ring is empty
+
+#define ASYNC_LOG(logger, level, ...) \
+    do { \
+        if ((level) >= ASYNC_LOG_LEVEL) { (logger).log((level), __VA_ARGS__); } \
+    } while (0)
+
+#define ASYNC_LOG_DEBUG(logger, ...) ASYNC_LOG(logger, ASYNC_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define ASYNC_LOG_INFO(logger, ...) ASYNC_LOG(logger, ASYNC_LOG_LEVEL_INFO, __VA_ARGS__)
+#define ASYNC_LOG_WARN(logger, ...) ASYNC_LOG(logger, ASYNC_LOG_LEVEL_WARN, __VA_ARGS__)
+#define ASYNC_LOG_ERROR(logger, ...) ASYNC_LOG(logger, ASYNC_LOG_LEVEL_ERROR, __VA_ARGS__)
+
+// Logger for the per-frame hot path.
+// log() formats the record straight into a slot of a bounded lock-free ring (no allocation, no lock,
+// no syscall) and a background thread drains the ring into the RCLCPP logger or into a file.
+// When the ring is full the record is dropped and counted instead of blocking the caller.
+class AsyncLogger
+{
+    public:
+        // Empty file_path: records go to the RCLCPP logger
+        AsyncLogger(const rclcpp::Logger& rclcpp_logger, const std::string& file_path = "");
+        ~AsyncLogger();
+
+        AsyncLogger(const AsyncLogger&) = delete;
+        AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+        // Safe to call from several threads at once
+        void log(int level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+        uint64_t dropped() const { return dropped_records.load(std::memory_order_relaxed); }
+
+    private:
+        struct Record {
+            std::atomic<size_t> sequence;
+            int64_t stamp_ns;
+            int level;
+            char text[ASYNC_LOG_RECORD_LENGTH];
+        };
+
+        rclcpp::Logger rclcpp_logger;
+        FILE* file;
+        std::unique_ptr<Record[]> ring;
+        alignas(64) std::atomic<size_t> enqueue_pos;
+        alignas(64) size_t dequeue_pos;
+        std::atomic<uint64_t> dropped_records;
+        std::atomic<bool> running;
+        std::thread drain_thread;
+
+        void drain_loop();
+        bool drain_one();
+        void write_record(const Record& record);
+};
+
+#endif  // ASYNC_LOGGER_HPP_
@@ -0,0 +1,72 @@
+#ifndef BOLT_ANGLE_HPP_
+#define BOLT_ANGLE_HPP_
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#define ANGLE_ROI_MARGIN 4 // Pixels kept around a contour bounding box for the Hough search
+#define ANGLE_POLYGON_EPSILON 0.02 // approxPolyDP tolerance, as a fraction of the contour perimeter
+#define ANGLE_RESERVED_CONTOURS 256 // Candidate contours the buffers are sized for by reserve()
+#define ANGLE_RESERVED_POINTS 64    // Hough lines / polygon vertices the buffers are sized for by reserve()
+
+// How the bolt angle is derived from a candidate contour
+enum class AngleEstimatorMode {
+    HOUGH,   // Canny + HoughLines on the filled contour
+    POLYGON  // Polygon approximation of the contour, edge normals folded modulo 60 degrees
+};
+
+// Parses "hough" / "polygon", returns false on an unknown name
+bool parse_angle_estimator_mode(const std::string& name, AngleEstimatorMode& mode);
+
+// Per worker buffers of the candidate evaluation
+struct AngleScratch {
+    cv::Mat bolt_contour_buf;
+    cv::Mat edges_buf;
+    std::vector<cv::Vec2f> lines;
+    std::vector<cv::Point> polygon;
+};
+
+// Finds the rotation angle of a hexagonal bolt / screw in a grayscale image.
+// Scratch buffers are kept between calls, so one instance should be reused per image stream.
+class BoltAngleEstimator
+{
+    public:
+        explicit BoltAngleEstimator(AngleEstimatorMode mode = AngleEstimatorMode::HOUGH) : mode(mode), parallel(false) {}
+
+        void set_mode(AngleEstimatorMode new_mode) { mode = new_mode; }
+        AngleEstimatorMode get_mode() const { return mode; }
+
+        // Evaluates the candidate contours concurrently (cv::parallel_for_), the selected contour stays
+        // the largest usable one
+        void set_parallel(bool enable) { parallel = enable; }
+        bool get_parallel() const { return parallel; }
+
+        // Allocates the scratch buffers (one set per worker) for images of the given size, so that the first
+        // call does not have to
+        void reserve(cv::Size image_size);
+
+        // Angle in degrees (in [0, 60[) of the largest usable contour, 0 if none is found
+        double find_rotation_angle(const cv::Mat& img_grayscale);
+
+    private:
+        AngleEstimatorMode mode;
+        bool parallel;
+
+        cv::Mat thresh;
+        std::vector<std::vector<cv::Point>> contours;
+        std::vector<std::pair<double, size_t>> contour_areas;
+        std::vector<AngleScratch> scratch;
+        std::vector<double> candidate_angles;
+
+        bool candidate_angle(size_t rank, AngleScratch& buffers, double& angle);
+        double find_angle_sequential();
+        double find_angle_parallel();
+        bool hough_angle(const std::vector<cv::Point>& contour, AngleScratch& buffers, double& angle);
+        bool polygon_angle(const std::vector<cv::Point>& contour, AngleScratch& buffers, double& angle);
+};
+
+#endif  // BOLT_ANGLE_HPP_
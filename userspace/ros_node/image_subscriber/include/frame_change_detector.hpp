@@ -0,0 +1,69 @@
+#ifndef FRAME_CHANGE_DETECTOR_HPP_
+#define FRAME_CHANGE_DETECTOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#define FRAME_DIFF_DEFAULT_STEP 8 // One luma sample every 8 pixels in both directions
+
+// Cheap scene change detector on YUYV frames.
+// The luma of every step-th pixel of every step-th row is gathered into a thumbnail, which is compared
+// (mean absolute difference) to the thumbnail of a reference frame.
+class FrameChangeDetector
+{
+    public:
+        explicit FrameChangeDetector(int step = FRAME_DIFF_DEFAULT_STEP) : step(step > 0 ? step : 1), has_reference(false) {}
+
+        // Mean absolute luma difference (0 - 255) between the frame and the reference, or -1 when there is
+        // no comparable reference (first frame, resolution change)
+        double distance(const uint8_t* yuyv, int width, int height, size_t stride)
+        {
+            int thumb_width = (width + step - 1) / step;
+            int thumb_height = (height + step - 1) / step;
+            bool comparable = has_reference && thumb_width == reference_width && thumb_height == reference_height;
+
+            current.resize(static_cast<size_t>(thumb_width) * thumb_height);
+            current_width = thumb_width;
+            current_height = thumb_height;
+
+            uint32_t sad = 0;
+            size_t i = 0;
+            for (int row = 0; row < height; row += step) {
+                const uint8_t* line = yuyv + row * stride;
+                for (int col = 0; col < width; col += step) {
+                    // Y0 U Y1 V: the luma of pixel col is at byte 2 * col
+                    uint8_t luma = line[2 * col];
+                    if (comparable) { sad += std::abs(static_cast<int>(luma) - static_cast<int>(reference[i])); }
+                    current[i++] = luma;
+                }
+            }
+
+            if (!comparable) { return -1; }
+            return static_cast<double>(sad) / static_cast<double>(current.size());
+        }
+
+        // Makes the last frame given to distance() the new reference
+        void set_reference()
+        {
+            reference.swap(current);
+            reference_width = current_width;
+            reference_height = current_height;
+            has_reference = true;
+        }
+
+        void reset() { has_reference = false; }
+
+    private:
+        int step;
+        bool has_reference;
+        std::vector<uint8_t> reference;
+        std::vector<uint8_t> current;
+        int reference_width = 0;
+        int reference_height = 0;
+        int current_width = 0;
+        int current_height = 0;
+};
+
+#endif  // FRAME_CHANGE_DETECTOR_HPP_
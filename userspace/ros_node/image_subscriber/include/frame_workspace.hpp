@@ -0,0 +1,85 @@
+#ifndef FRAME_WORKSPACE_HPP_
+#define FRAME_WORKSPACE_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+
+#define RESIZED_IMG_WIDTH 20
+#define RESIZED_IMG_HEIGHT 15
+#define NN_INPUT_SIZE (RESIZED_IMG_WIDTH * RESIZED_IMG_HEIGHT * 3)
+#define NN_INPUT_BUFFERS 17 // NN inputs in flight at once: the whole frame and up to 16 crops
+
+// ITU-R BT.601 YUV -> RGB fixed-point coefficients, the ones of cv::COLOR_YUV2RGB_YUY2
+#define BT601_CY 1220542
+#define BT601_CUB 2116026
+#define BT601_CUG -409993
+#define BT601_CVG -852492
+#define BT601_CVR 1673527
+#define BT601_SHIFT 20
+
+// Per-frame buffers of the node, allocated for the size of the first frame and reused by the following ones
+// (reallocated only if the camera resolution changes)
+struct FrameWorkspace {
+    cv::Mat img_rgb;
+    cv::Mat resized_img;
+    cv::Mat img_grayscale;
+    std::array<float, NN_INPUT_BUFFERS * NN_INPUT_SIZE> nn_inputs;
+    cv::Size frame_size;
+
+    // Returns true when the buffers were (re)allocated
+    bool reserve(cv::Size size)
+    {
+        if (size == frame_size) { return false; }
+
+        frame_size = size;
+        img_rgb.create(size, CV_8UC3);
+        img_grayscale.create(size, CV_8UC1);
+        resized_img.create(RESIZED_IMG_HEIGHT, RESIZED_IMG_WIDTH, CV_8UC3);
+        return true;
+    }
+
+    float* nn_input(int index) { return nn_inputs.data() + index * NN_INPUT_SIZE; }
+};
+
+static inline uint8_t bt601_clamp(int value)
+{
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+// Same result as cv::cvtColor(yuyv, rgb, cv::COLOR_YUV2RGB_YUY2), without going through the OpenCV thread
+// pool (which allocates a job per call). rgb must already have the size of the frame.
+// Throws cv::Exception like cv::cvtColor if yuyv is not a YUYV image (CV_8UC2, even width).
+static inline void yuyv_to_rgb(const cv::Mat& yuyv, cv::Mat& rgb)
+{
+    CV_Assert(yuyv.type() == CV_8UC2 && yuyv.cols % 2 == 0);
+    CV_Assert(rgb.type() == CV_8UC3 && rgb.size() == yuyv.size());
+
+    const int round = 1 << (BT601_SHIFT - 1);
+    for (int row = 0; row < yuyv.rows; row++) {
+        const uint8_t* src = yuyv.ptr<uint8_t>(row);
+        uint8_t* dst = rgb.ptr<uint8_t>(row);
+        for (int col = 0; col < yuyv.cols; col += 2, src += 4, dst += 6) {
+            // Y0 U Y1 V: two pixels sharing their chroma
+            int u = static_cast<int>(src[1]) - 128;
+            int v = static_cast<int>(src[3]) - 128;
+            int ruv = round + BT601_CVR * v;
+            int guv = round + BT601_CVG * v + BT601_CUG * u;
+            int buv = round + BT601_CUB * u;
+
+            int y0 = std::max(0, static_cast<int>(src[0]) - 16) * BT601_CY;
+            dst[0] = bt601_clamp((y0 + ruv) >> BT601_SHIFT);
+            dst[1] = bt601_clamp((y0 + guv) >> BT601_SHIFT);
+            dst[2] = bt601_clamp((y0 + buv) >> BT601_SHIFT);
+
+            int y1 = std::max(0, static_cast<int>(src[2]) - 16) * BT601_CY;
+            dst[3] = bt601_clamp((y1 + ruv) >> BT601_SHIFT);
+            dst[4] = bt601_clamp((y1 + guv) >> BT601_SHIFT);
+            dst[5] = bt601_clamp((y1 + buv) >> BT601_SHIFT);
+        }
+    }
+}
+
+#endif  // FRAME_WORKSPACE_HPP_
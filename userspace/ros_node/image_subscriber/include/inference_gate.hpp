@@ -0,0 +1,60 @@
+#ifndef INFERENCE_GATE_HPP_
+#define INFERENCE_GATE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_change_detector.hpp"
+#include "motor_settle_tracker.hpp"
+
+// Frame-difference gate of the inferences: the last prediction is reused for a frame when the motor is settled
+// on the command it had at the last inference (it was not commanded since) and the scene did not change.
+class InferenceGate
+{
+    public:
+        // threshold: mean absolute luma difference (0 - 255) under which a frame is unchanged, 0 disables the gate
+        explicit InferenceGate(double threshold = 0, int step = FRAME_DIFF_DEFAULT_STEP)
+        : threshold(threshold),
+          detector(step),
+          has_inference(false),
+          inference_command(0),
+          last_distance(-1)
+        {}
+
+        // Whether the last prediction holds for the YUYV frame. Otherwise the frame becomes the reference of
+        // the next ones, and inferred() is expected once its inference ran.
+        bool reuse(const uint8_t* yuyv, int width, int height, size_t stride, const MotorSettleTracker& motor)
+        {
+            if (threshold <= 0) { return false; }
+
+            last_distance = detector.distance(yuyv, width, height, stride);
+            bool motor_idle = has_inference && motor.settled() && motor.current_command() == inference_command;
+            if (motor_idle && last_distance >= 0 && last_distance < threshold) { return true; }
+            detector.set_reference();
+            return false;
+        }
+
+        void inferred(const MotorSettleTracker& motor)
+        {
+            has_inference = true;
+            inference_command = motor.current_command();
+        }
+
+        void reset()
+        {
+            detector.reset();
+            has_inference = false;
+        }
+
+        // Difference computed by the last reuse(), -1 without comparable reference
+        double distance() const { return last_distance; }
+
+    private:
+        double threshold;
+        FrameChangeDetector detector;
+        bool has_inference;
+        uint32_t inference_command; // Motor command when the last inference ran
+        double last_distance;
+};
+
+#endif  // INFERENCE_GATE_HPP_
@@ -0,0 +1,98 @@
+#ifndef INFERENCE_SCHEDULER_HPP_
+#define INFERENCE_SCHEDULER_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "realtime.hpp"
+#include "xnn_inference.h"
+
+#define INFERENCE_MAX_JOBS 32           // Inferences submitted and not waited for yet
+#define INFERENCE_FPGA_PRIOR_US 150     // Service time estimates until the first measurements
+#define INFERENCE_CPU_PRIOR_US 600
+#define INFERENCE_SERVICE_TIME_ALPHA 0.1 // Weight of the last measurement in the service time estimates
+
+// Dispatches NN inferences to the FPGA IP core and to CPU workers running nn_cpu_inference().
+// Each backend (the IP, every CPU worker) has its own thread and queue. A request goes to the backend with
+// the earliest estimated completion time: when its queue drains, plus the estimated service time of its kind
+// (moving average of the measured ones, shared by the CPU workers).
+// Without IP (initialization failed) everything runs on the CPU workers.
+// In real-time mode the workers get the settings of the caller thread: a SCHED_FIFO caller blocked in wait()
+// on a default policy worker would be delayed by any other process (priority inversion).
+// submit() / wait() are meant for one caller thread and do not allocate.
+class InferenceScheduler
+{
+    public:
+        struct BackendStats {
+            const char* name;
+            uint64_t inferences;
+            double mean_service_us;
+            double utilization; // Busy time over the time since the scheduler started (0 - 1)
+        };
+
+        // ip: initialized IP core, nullptr if unavailable
+        // realtime: pinning and SCHED_FIFO priority applied by every worker thread, nullptr to keep the default policy
+        InferenceScheduler(XNn_inference* ip, int cpu_workers, const RealtimeConfig* realtime = nullptr);
+        ~InferenceScheduler();
+
+        InferenceScheduler(const InferenceScheduler&) = delete;
+        InferenceScheduler& operator=(const InferenceScheduler&) = delete;
+
+        bool has_backends() const { return !backends.empty(); }
+        // First error of the workers applying the real-time settings, empty if they all succeeded
+        const std::string& realtime_error() const { return worker_error; }
+
+        // Queues an inference of nn_input (NN_INPUTS floats, must stay untouched until wait()).
+        // Returns a ticket for wait(), or -1 if INFERENCE_MAX_JOBS are already pending or there is no backend.
+        int submit(const float* nn_input);
+        // Blocks until the inference of the ticket is done, returns the NN output (UINT32_MAX for an invalid ticket)
+        uint32_t wait(int ticket);
+
+        size_t backend_count() const { return backends.size(); }
+        BackendStats backend_stats(size_t index);
+
+    private:
+        enum class BackendKind { FPGA, CPU, COUNT };
+
+        struct Backend {
+            BackendKind kind;
+            char name[16];
+            std::thread thread;
+            std::condition_variable work_cv;
+            int queue[INFERENCE_MAX_JOBS];
+            int queue_head;
+            int queue_count;
+            int64_t available_at_ns;   // Estimated time when the queued work is done
+            int64_t busy_ns;
+            uint64_t inferences;
+        };
+
+        struct Job {
+            const float* input;
+            uint32_t output;
+            bool pending;
+            bool done;
+        };
+
+        XNn_inference* ip;
+        std::vector<std::unique_ptr<Backend>> backends;
+        double service_ns[(int)BackendKind::COUNT]; // Estimated service time per backend kind
+        Job jobs[INFERENCE_MAX_JOBS];
+        std::mutex mutex;
+        std::condition_variable done_cv;
+        bool stopping;
+        int64_t start_ns;
+        size_t workers_started;
+        std::string worker_error;
+
+        static int64_t now_ns();
+        void worker_loop(Backend& backend, const RealtimeConfig* realtime);
+        uint32_t run(Backend& backend, const float* nn_input);
+};
+
+#endif  // INFERENCE_SCHEDULER_HPP_
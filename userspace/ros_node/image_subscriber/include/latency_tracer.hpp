@@ -0,0 +1,109 @@
+#ifndef LATENCY_TRACER_HPP_
+#define LATENCY_TRACER_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <string>
+
+#define TRACE_STAGE_COUNT 4
+#define TRACE_MAX_PENDING 64               // Frames waiting for their motor write acknowledgements
+#define TRACE_ACK_TIMEOUT_NS 1000000000LL // Pending frames are closed without motor write after this
+#define TRACE_FILE_BUFFER_SIZE 65536
+
+// Processing stages of a frame, in the order they happen
+enum class TraceStage {
+    PREPROCESS, // Frame conversion, resize and normalization
+    INFERENCE,  // NN IP core run
+    ANGLE,      // Bolt angle estimation
+    PUBLISH     // SetPosition publish call
+};
+
+const char* trace_stage_name(TraceStage stage);
+
+// Trace of one processed frame. Times are nanoseconds on the clock of the camera header stamps (ROS time),
+// 0 when the step did not happen.
+struct FrameTraceRecord {
+    uint32_t trace_id;
+    int64_t capture_ns;                        // Camera header stamp
+    int64_t receive_ns;                        // Entry of the image callback
+    int64_t stage_start_ns[TRACE_STAGE_COUNT]; // First start of each stage
+    int64_t stage_ns[TRACE_STAGE_COUNT];       // Total time spent in each stage
+    int64_t end_ns;                            // Exit of the image callback
+    int64_t publish_ns;                        // Last SetPosition publish
+    int64_t motor_write_ns;                    // Last servo write acknowledged by read_write_node
+    uint8_t commands;                          // SetPosition published for the frame
+    uint8_t acks;                              // of which acknowledged
+};
+
+// Per-frame latency tracing from the camera stamp to the servo write.
+// The image callback brackets each frame with begin_frame() / end_frame() and its stages with TraceScope.
+// A frame that published motor commands stays pending until read_write_node acknowledged them all (or
+// TRACE_ACK_TIMEOUT_NS passed). Completed records go to the CSV and Chrome trace files when set, and to the
+// completion callback. Not thread safe: all calls come from the node executor.
+class LatencyTracer
+{
+    public:
+        typedef std::function<void(const FrameTraceRecord&)> CompletionCallback;
+
+        // Empty paths: no file export
+        LatencyTracer(const std::string& csv_path = "", const std::string& chrome_trace_path = "");
+        ~LatencyTracer();
+
+        LatencyTracer(const LatencyTracer&) = delete;
+        LatencyTracer& operator=(const LatencyTracer&) = delete;
+
+        static int64_t now_ns();
+
+        void set_enabled(bool enabled) { this->enabled = enabled; }
+        bool get_enabled() const { return enabled; }
+        void set_completion_callback(CompletionCallback callback) { on_complete = callback; }
+
+        void begin_frame(int64_t capture_ns);
+        void stage_begin(TraceStage stage);
+        void stage_end(TraceStage stage);
+        // Trace id to send with a SetPosition of the current frame (0 outside of a frame)
+        uint32_t command_published();
+        void end_frame();
+
+        // Servo write acknowledgement of a SetPosition sent with trace_id
+        void motor_written(uint32_t trace_id, int64_t write_ns);
+
+    private:
+        bool enabled;
+        bool in_frame;
+        uint32_t next_trace_id;
+        FrameTraceRecord current;
+        int64_t current_stage_start_ns[TRACE_STAGE_COUNT];
+        std::deque<FrameTraceRecord> pending;
+        CompletionCallback on_complete;
+
+        FILE* csv_file;
+        FILE* chrome_file;
+        bool chrome_first_event;
+        int64_t chrome_origin_ns;
+
+        void complete(const FrameTraceRecord& record);
+        void expire_pending(int64_t now_ns);
+        void write_csv(const FrameTraceRecord& record);
+        void write_chrome_trace(const FrameTraceRecord& record);
+        void chrome_event(const char* name, int tid, int64_t start_ns, int64_t duration_ns, uint32_t trace_id);
+};
+
+// Times a stage of the current frame for the lifetime of the scope
+class TraceScope
+{
+    public:
+        TraceScope(LatencyTracer& tracer, TraceStage stage) : tracer(tracer), stage(stage) { tracer.stage_begin(stage); }
+        ~TraceScope() { tracer.stage_end(stage); }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+    private:
+        LatencyTracer& tracer;
+        TraceStage stage;
+};
+
+#endif  // LATENCY_TRACER_HPP_
@@ -0,0 +1,74 @@
+#ifndef MOTOR_SETTLE_TRACKER_HPP_
+#define MOTOR_SETTLE_TRACKER_HPP_
+
+#include <cstdint>
+#include <cstdlib>
+
+// Tracks whether a motor reached its last commanded position, and from when camera frames show it at rest.
+// Times are nanoseconds on the same clock as the camera header stamps.
+class MotorSettleTracker
+{
+    public:
+        // tolerance: max distance (motor units) between the read back and the commanded positions
+        // settle_delay_ns: margin after the settle time before a frame capture is trusted (exposure, vibrations)
+        // settle_timeout_ns: the motor is considered settled this long after a command even without read back
+        MotorSettleTracker(int32_t tolerance = 0, int64_t settle_delay_ns = 0, int64_t settle_timeout_ns = 0)
+        : tolerance(tolerance),
+          settle_delay_ns(settle_delay_ns),
+          settle_timeout_ns(settle_timeout_ns),
+          command_id(0),
+          commanded(0),
+          commanded_ns(0),
+          settled_ns(0),
+          is_settled(true)
+        {}
+
+        void command(int32_t position, int64_t now_ns)
+        {
+            command_id++;
+            commanded = position;
+            commanded_ns = now_ns;
+            is_settled = false;
+        }
+
+        // Present position read back for the command command_id (see current_command()), at time now_ns.
+        // Returns true when the motor is settled after this read.
+        bool position_read(uint32_t for_command_id, int32_t position, int64_t now_ns)
+        {
+            if (is_settled || for_command_id != command_id) { return is_settled; }
+            if (std::abs(position - commanded) <= tolerance) {
+                // The read may have happened any time before the response, so the response time is used
+                settled_ns = now_ns;
+                is_settled = true;
+            }
+            return is_settled;
+        }
+
+        void check_timeout(int64_t now_ns)
+        {
+            if (!is_settled && now_ns - commanded_ns >= settle_timeout_ns) {
+                settled_ns = now_ns;
+                is_settled = true;
+            }
+        }
+
+        bool settled() const { return is_settled; }
+
+        // Whether a frame captured at stamp_ns shows the motor at rest at the commanded position
+        bool frame_usable(int64_t stamp_ns) const { return is_settled && stamp_ns >= settled_ns + settle_delay_ns; }
+
+        uint32_t current_command() const { return command_id; }
+        int32_t commanded_position() const { return commanded; }
+
+    private:
+        int32_t tolerance;
+        int64_t settle_delay_ns;
+        int64_t settle_timeout_ns;
+        uint32_t command_id;
+        int32_t commanded;
+        int64_t commanded_ns;
+        int64_t settled_ns;
+        bool is_settled;
+};
+
+#endif  // MOTOR_SETTLE_TRACKER_HPP_
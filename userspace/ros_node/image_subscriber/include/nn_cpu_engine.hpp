@@ -0,0 +1,17 @@
+#ifndef NN_CPU_ENGINE_HPP_
+#define NN_CPU_ENGINE_HPP_
+
+#include <cstdint>
+
+// Layer sizes of the bolt classifier, as in HLS_IPs/HLS_IP/nn.hpp
+#define NN_INPUTS 900
+#define NN_LAYER1 32
+#define NN_LAYER2 24
+#define NN_LAYER3 4
+
+// Host implementation of the nn_inference IP core: dense 900 -> 32 -> 24 -> 4 without bias, ReLU on the two
+// hidden layers, argmax of the last one. Same weights (AI_training/layer_*_weights.txt) and same summation
+// order as the IP. Reentrant, no allocation.
+uint32_t nn_cpu_inference(const float* input_img);
+
+#endif  // NN_CPU_ENGINE_HPP_
@@ -0,0 +1,30 @@
+#ifndef REALTIME_HPP_
+#define REALTIME_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#define RT_DEFAULT_PRIORITY 80          // SCHED_FIFO priority of the real-time threads (1 - 99)
+#define RT_DEFAULT_PREFAULT_MB 64       // Heap prefaulted and kept by the allocator
+#define RT_STACK_PREFAULT_BYTES (512 * 1024)
+
+// Real-time execution settings of a thread and of the process memory
+struct RealtimeConfig {
+    std::vector<int> cpus;      // Cores the thread is pinned to (isolcpus), empty: no pinning
+    int priority;               // SCHED_FIFO priority, 0: keep the default policy
+    size_t prefault_heap_bytes; // Heap touched once and never returned to the system
+};
+
+// mlockall() the current and future pages, stop the allocator from trimming or mmap()ing blocks, then
+// prefault prefault_heap_bytes of heap so the first allocations of the steady state do not page fault
+bool lock_process_memory(size_t prefault_heap_bytes, std::string& error);
+
+// Pins the calling thread, sets its SCHED_FIFO priority and prefaults its stack
+bool configure_realtime_thread(const RealtimeConfig& config, std::string& error);
+
+bool pin_current_thread(const std::vector<int>& cpus, std::string& error);
+bool set_current_thread_fifo(int priority, std::string& error);
+void prefault_stack(size_t bytes);
+
+#endif  // REALTIME_HPP_
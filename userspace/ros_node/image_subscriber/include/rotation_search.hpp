@@ -0,0 +1,86 @@
+#ifndef ROTATION_SEARCH_HPP_
+#define ROTATION_SEARCH_HPP_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Decides where the rotation motor looks next while searching for the bolt
+class RotationSearchStrategy
+{
+    public:
+        virtual ~RotationSearchStrategy() = default;
+
+        // Restarts the search and returns the first position to look at
+        virtual int reset() = 0;
+
+        // Gives the NN output at the current position and sets the next position to look at.
+        // Returns false (position unchanged) once every position has been visited.
+        virtual bool next(uint32_t nn_output, int& position) = 0;
+
+        // Moves the search to position outside of next() (e.g. towards the bolt seen in a crop): the search goes
+        // on from there, so that next() does not send the motor back to where the plan was.
+        // Returns false, search unchanged, if position (clamped to the range) was already visited since reset():
+        // a hint that keeps pointing back (a crop false positive) cannot hold the search, it still ends.
+        virtual bool seek(int position) = 0;
+};
+
+// Visits the positions one by one from start to end (inclusive), one step per frame, skipping the visited ones.
+// seek() moves the scan to a position not visited yet.
+class LinearSearch : public RotationSearchStrategy
+{
+    public:
+        LinearSearch(int start, int end, int step);
+
+        int reset() override;
+        bool next(uint32_t nn_output, int& position) override;
+        bool seek(int position) override;
+
+    private:
+        int start;
+        int end;
+        int step;
+        int current;
+        std::vector<bool> visited; // Indexed by distance to start
+};
+
+// Sweeps the range with the first (largest) step of the plan, then with the next steps over the positions
+// not visited yet. When the NN output changes between two consecutive positions of a sweep, the interval
+// between them is scanned right away with the last (finest) step of the plan. After a seek(), the positions
+// around the new one (up to half the largest step) are scanned first with the finest step, then the plan resumes.
+class CoarseToFineSearch : public RotationSearchStrategy
+{
+    public:
+        // step_plan holds positive, decreasing step sizes, e.g. {32, 8, 1}
+        CoarseToFineSearch(int start, int end, const std::vector<int>& step_plan);
+
+        int reset() override;
+        bool next(uint32_t nn_output, int& position) override;
+        bool seek(int position) override;
+
+    private:
+        int start;
+        int end;
+        int direction;
+        std::vector<int> step_plan;
+
+        std::vector<bool> visited;  // Indexed by distance to start
+        size_t pass;
+        std::deque<int> sweep;      // Remaining positions of the current pass
+        std::deque<int> refinement; // Positions between two sweep positions with different outputs
+        int current;
+        bool current_is_sweep;  // Current position comes from the sweep (not a refinement or a seek)
+        bool has_previous_sweep;
+        int previous_sweep_position;
+        uint32_t previous_sweep_output;
+
+        bool is_visited(int position) const { return visited[(position - start) * direction]; }
+        void fill_sweep();
+        bool pop_next(int& position);
+};
+
+// Linear search for a plan of a single step of 1, coarse-to-fine search otherwise
+std::unique_ptr<RotationSearchStrategy> make_rotation_search(int start, int end, const std::vector<int>& step_plan);
+
+#endif  // ROTATION_SEARCH_HPP_
@@ -0,0 +1,155 @@
+// ==============================================================
+// Vitis HLS - High-Level Synthesis from C, C++ and OpenCL v2020.2 (64-bit)
+// Copyright 1986-2020 Xilinx, Inc. All Rights Reserved.
+// ==============================================================
+#ifndef XEDGE_ANGLE_H
+#define XEDGE_ANGLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************** Include Files *********************************/
+#ifndef __linux__
+#include "xil_types.h"
+#include "xil_assert.h"
+#include "xstatus.h"
+#include "xil_io.h"
+#else
+#include <stdint.h>
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stddef.h>
+#endif
+#include "xedge_angle_hw.h"
+
+/**************************** Type Definitions ******************************/
+#ifdef __linux__
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+#else
+typedef struct {
+    u16 DeviceId;
+    u32 Axi_cpu_BaseAddress;
+} XEdge_angle_Config;
+#endif
+
+typedef struct {
+    u64 Axi_cpu_BaseAddress;
+    u32 IsReady;
+} XEdge_angle;
+
+typedef u32 word_type;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+#ifndef __linux__
+#define XEdge_angle_WriteReg(BaseAddress, RegOffset, Data) \
+    Xil_Out32((BaseAddress) + (RegOffset), (u32)(Data))
+#define XEdge_angle_ReadReg(BaseAddress, RegOffset) \
+    Xil_In32((BaseAddress) + (RegOffset))
+#else
+#define XEdge_angle_WriteReg(BaseAddress, RegOffset, Data) \
+    *(volatile u32*)((BaseAddress) + (RegOffset)) = (u32)(Data)
+#define XEdge_angle_ReadReg(BaseAddress, RegOffset) \
+    *(volatile u32*)((BaseAddress) + (RegOffset))
+
+#define Xil_AssertVoid(expr)    assert(expr)
+#define Xil_AssertNonvoid(expr) assert(expr)
+
+#define XST_SUCCESS             0
+#define XST_DEVICE_NOT_FOUND    2
+#define XST_OPEN_DEVICE_FAILED  3
+#define XIL_COMPONENT_IS_READY  1
+#endif
+
+/************************** Function Prototypes *****************************/
+#ifndef __linux__
+int XEdge_angle_Initialize(XEdge_angle *InstancePtr, u16 DeviceId);
+XEdge_angle_Config* XEdge_angle_LookupConfig(u16 DeviceId);
+int XEdge_angle_CfgInitialize(XEdge_angle *InstancePtr, XEdge_angle_Config *ConfigPtr);
+#else
+int XEdge_angle_Initialize(XEdge_angle *InstancePtr, const char* InstanceName);
+int XEdge_angle_Release(XEdge_angle *InstancePtr);
+#endif
+
+void XEdge_angle_Start(XEdge_angle *InstancePtr);
+u32 XEdge_angle_IsDone(XEdge_angle *InstancePtr);
+u32 XEdge_angle_IsIdle(XEdge_angle *InstancePtr);
+u32 XEdge_angle_IsReady(XEdge_angle *InstancePtr);
+void XEdge_angle_EnableAutoRestart(XEdge_angle *InstancePtr);
+void XEdge_angle_DisableAutoRestart(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_return(XEdge_angle *InstancePtr);
+
+void XEdge_angle_Set_frame(XEdge_angle *InstancePtr, u64 Data);
+u64 XEdge_angle_Get_frame(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_edges(XEdge_angle *InstancePtr, u64 Data);
+u64 XEdge_angle_Get_edges(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_stride(XEdge_angle *InstancePtr, u32 Data);
+u32 XEdge_angle_Get_stride(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_roi_x(XEdge_angle *InstancePtr, u32 Data);
+u32 XEdge_angle_Get_roi_x(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_roi_y(XEdge_angle *InstancePtr, u32 Data);
+u32 XEdge_angle_Get_roi_y(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_roi_width(XEdge_angle *InstancePtr, u32 Data);
+u32 XEdge_angle_Get_roi_width(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_roi_height(XEdge_angle *InstancePtr, u32 Data);
+u32 XEdge_angle_Get_roi_height(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_threshold(XEdge_angle *InstancePtr, u32 Data);
+u32 XEdge_angle_Get_threshold(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_theta_first(XEdge_angle *InstancePtr, u32 Data);
+u32 XEdge_angle_Get_theta_first(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_theta_count(XEdge_angle *InstancePtr, u32 Data);
+u32 XEdge_angle_Get_theta_count(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_hough_threshold(XEdge_angle *InstancePtr, u32 Data);
+u32 XEdge_angle_Get_hough_threshold(XEdge_angle *InstancePtr);
+void XEdge_angle_Set_debug_edges(XEdge_angle *InstancePtr, u32 Data);
+u32 XEdge_angle_Get_debug_edges(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_theta_BaseAddress(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_theta_HighAddress(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_theta_TotalBytes(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_theta_BitWidth(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_theta_Depth(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Write_line_theta_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length);
+u32 XEdge_angle_Read_line_theta_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length);
+u32 XEdge_angle_Write_line_theta_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length);
+u32 XEdge_angle_Read_line_theta_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length);
+u32 XEdge_angle_Get_line_rho_BaseAddress(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_rho_HighAddress(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_rho_TotalBytes(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_rho_BitWidth(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_rho_Depth(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Write_line_rho_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length);
+u32 XEdge_angle_Read_line_rho_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length);
+u32 XEdge_angle_Write_line_rho_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length);
+u32 XEdge_angle_Read_line_rho_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length);
+u32 XEdge_angle_Get_line_votes_BaseAddress(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_votes_HighAddress(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_votes_TotalBytes(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_votes_BitWidth(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Get_line_votes_Depth(XEdge_angle *InstancePtr);
+u32 XEdge_angle_Write_line_votes_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length);
+u32 XEdge_angle_Read_line_votes_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length);
+u32 XEdge_angle_Write_line_votes_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length);
+u32 XEdge_angle_Read_line_votes_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length);
+
+void XEdge_angle_InterruptGlobalEnable(XEdge_angle *InstancePtr);
+void XEdge_angle_InterruptGlobalDisable(XEdge_angle *InstancePtr);
+void XEdge_angle_InterruptEnable(XEdge_angle *InstancePtr, u32 Mask);
+void XEdge_angle_InterruptDisable(XEdge_angle *InstancePtr, u32 Mask);
+void XEdge_angle_InterruptClear(XEdge_angle *InstancePtr, u32 Mask);
+u32 XEdge_angle_InterruptGetEnabled(XEdge_angle *InstancePtr);
+u32 XEdge_angle_InterruptGetStatus(XEdge_angle *InstancePtr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
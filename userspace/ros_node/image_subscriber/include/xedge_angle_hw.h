@@ -0,0 +1,118 @@
+// ==============================================================
+// Vitis HLS - High-Level Synthesis from C, C++ and OpenCL v2020.2 (64-bit)
+// Copyright 1986-2020 Xilinx, Inc. All Rights Reserved.
+// ==============================================================
+// AXI_CPU
+// 0x00 : Control signals
+//        bit 0  - ap_start (Read/Write/COH)
+//        bit 1  - ap_done (Read/COR)
+//        bit 2  - ap_idle (Read)
+//        bit 3  - ap_ready (Read)
+//        bit 7  - auto_restart (Read/Write)
+//        others - reserved
+// 0x04 : Global Interrupt Enable Register
+//        bit 0  - Global Interrupt Enable (Read/Write)
+//        others - reserved
+// 0x08 : IP Interrupt Enable Register (Read/Write)
+//        bit 0  - enable ap_done interrupt (Read/Write)
+//        bit 1  - enable ap_ready interrupt (Read/Write)
+//        others - reserved
+// 0x0c : IP Interrupt Status Register (Read/TOW)
+//        bit 0  - ap_done (COR/TOW)
+//        bit 1  - ap_ready (COR/TOW)
+//        others - reserved
+// 0x10 : Data signal of ap_return
+//        bit 31~0 - ap_return[31:0] (Read)
+// 0x18 : Data signal of frame
+//        bit 31~0 - frame[31:0] (Read/Write)
+// 0x1c : Data signal of frame
+//        bit 31~0 - frame[63:32] (Read/Write)
+// 0x20 : reserved
+// 0x24 : Data signal of edges
+//        bit 31~0 - edges[31:0] (Read/Write)
+// 0x28 : Data signal of edges
+//        bit 31~0 - edges[63:32] (Read/Write)
+// 0x2c : reserved
+// 0x30 : Data signal of stride
+//        bit 31~0 - stride[31:0] (Read/Write)
+// 0x34 : reserved
+// 0x38 : Data signal of roi_x
+//        bit 31~0 - roi_x[31:0] (Read/Write)
+// 0x3c : reserved
+// 0x40 : Data signal of roi_y
+//        bit 31~0 - roi_y[31:0] (Read/Write)
+// 0x44 : reserved
+// 0x48 : Data signal of roi_width
+//        bit 31~0 - roi_width[31:0] (Read/Write)
+// 0x4c : reserved
+// 0x50 : Data signal of roi_height
+//        bit 31~0 - roi_height[31:0] (Read/Write)
+// 0x54 : reserved
+// 0x58 : Data signal of threshold
+//        bit 31~0 - threshold[31:0] (Read/Write)
+// 0x5c : reserved
+// 0x60 : Data signal of theta_first
+//        bit 31~0 - theta_first[31:0] (Read/Write)
+// 0x64 : reserved
+// 0x68 : Data signal of theta_count
+//        bit 31~0 - theta_count[31:0] (Read/Write)
+// 0x6c : reserved
+// 0x70 : Data signal of hough_threshold
+//        bit 31~0 - hough_threshold[31:0] (Read/Write)
+// 0x74 : reserved
+// 0x78 : Data signal of debug_edges
+//        bit 31~0 - debug_edges[31:0] (Read/Write)
+// 0x7c : reserved
+// 0x80 ~
+// 0x9f : Memory 'line_theta' (8 * 32b)
+//        Word n : bit [31:0] - line_theta[n]
+// 0xa0 ~
+// 0xbf : Memory 'line_rho' (8 * 32b)
+//        Word n : bit [31:0] - line_rho[n]
+// 0xc0 ~
+// 0xdf : Memory 'line_votes' (8 * 32b)
+//        Word n : bit [31:0] - line_votes[n]
+// (SC = Self Clear, COR = Clear on Read, TOW = Toggle on Write, COH = Clear on Handshake)
+
+#define XEDGE_ANGLE_AXI_CPU_ADDR_AP_CTRL              0x00
+#define XEDGE_ANGLE_AXI_CPU_ADDR_GIE                  0x04
+#define XEDGE_ANGLE_AXI_CPU_ADDR_IER                  0x08
+#define XEDGE_ANGLE_AXI_CPU_ADDR_ISR                  0x0c
+#define XEDGE_ANGLE_AXI_CPU_ADDR_AP_RETURN            0x10
+#define XEDGE_ANGLE_AXI_CPU_BITS_AP_RETURN            32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_FRAME_DATA           0x18
+#define XEDGE_ANGLE_AXI_CPU_BITS_FRAME_DATA           64
+#define XEDGE_ANGLE_AXI_CPU_ADDR_EDGES_DATA           0x24
+#define XEDGE_ANGLE_AXI_CPU_BITS_EDGES_DATA           64
+#define XEDGE_ANGLE_AXI_CPU_ADDR_STRIDE_DATA          0x30
+#define XEDGE_ANGLE_AXI_CPU_BITS_STRIDE_DATA          32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_ROI_X_DATA           0x38
+#define XEDGE_ANGLE_AXI_CPU_BITS_ROI_X_DATA           32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_ROI_Y_DATA           0x40
+#define XEDGE_ANGLE_AXI_CPU_BITS_ROI_Y_DATA           32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_ROI_WIDTH_DATA       0x48
+#define XEDGE_ANGLE_AXI_CPU_BITS_ROI_WIDTH_DATA       32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_ROI_HEIGHT_DATA      0x50
+#define XEDGE_ANGLE_AXI_CPU_BITS_ROI_HEIGHT_DATA      32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_THRESHOLD_DATA       0x58
+#define XEDGE_ANGLE_AXI_CPU_BITS_THRESHOLD_DATA       32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_THETA_FIRST_DATA     0x60
+#define XEDGE_ANGLE_AXI_CPU_BITS_THETA_FIRST_DATA     32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_THETA_COUNT_DATA     0x68
+#define XEDGE_ANGLE_AXI_CPU_BITS_THETA_COUNT_DATA     32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_HOUGH_THRESHOLD_DATA 0x70
+#define XEDGE_ANGLE_AXI_CPU_BITS_HOUGH_THRESHOLD_DATA 32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_DEBUG_EDGES_DATA     0x78
+#define XEDGE_ANGLE_AXI_CPU_BITS_DEBUG_EDGES_DATA     32
+#define XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE      0x80
+#define XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_HIGH      0x9f
+#define XEDGE_ANGLE_AXI_CPU_WIDTH_LINE_THETA          32
+#define XEDGE_ANGLE_AXI_CPU_DEPTH_LINE_THETA          8
+#define XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE        0xa0
+#define XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_HIGH        0xbf
+#define XEDGE_ANGLE_AXI_CPU_WIDTH_LINE_RHO            32
+#define XEDGE_ANGLE_AXI_CPU_DEPTH_LINE_RHO            8
+#define XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE      0xc0
+#define XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_HIGH      0xdf
+#define XEDGE_ANGLE_AXI_CPU_WIDTH_LINE_VOTES          32
+#define XEDGE_ANGLE_AXI_CPU_DEPTH_LINE_VOTES          8
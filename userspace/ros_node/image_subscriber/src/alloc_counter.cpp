@@ -0,0 +1,83 @@
+#include "alloc_counter.hpp"
+
+#ifdef ALLOC_COUNTER
+
+#include <cerrno>
+#include <cstddef>
+
+// glibc entry points of the allocator, the replacements below only count and forward.
+// operator new and OpenCV's fastMalloc both end up in these.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+
+// Thread local storage of the executable itself: accessed without any allocation
+static thread_local int counting_depth = 0;
+static thread_local uint64_t thread_allocations = 0;
+
+static inline void count_allocation()
+{
+    if (counting_depth > 0) { thread_allocations++; }
+}
+
+uint64_t alloc_counter_begin()
+{
+    counting_depth++;
+    return thread_allocations;
+}
+
+uint64_t alloc_counter_end(uint64_t begin_count)
+{
+    counting_depth--;
+    return thread_allocations - begin_count;
+}
+
+extern "C" {
+
+void* malloc(size_t size)
+{
+    count_allocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    count_allocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    count_allocation();
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) { return EINVAL; }
+
+    count_allocation();
+    void* block = __libc_memalign(alignment, size);
+    if (block == nullptr) { return ENOMEM; }
+    *ptr = block;
+    return 0;
+}
+
+}
+
+#endif  // ALLOC_COUNTER
@@ -0,0 +1,119 @@
+// Compares the speed and the angular error of the bolt angle estimators on a labelled image set.
+//
+// Usage:
+// $ ros2 run image_subscriber angle_estimator_benchmark <image_dir> <labels.csv> [repetitions]
+//
+// labels.csv holds one "<image file name>,<bolt angle in degrees>" line per image. The images are read as
+// grayscale, like the output of cv::cvtColor(camera_img, img, cv::COLOR_YUV2GRAY_YUY2) in the node.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "bolt_angle.hpp"
+
+struct LabelledImage {
+    std::string name;
+    cv::Mat img;
+    double angle;
+};
+
+struct EstimatorStats {
+    const char* name;
+    AngleEstimatorMode mode;
+    bool parallel;
+    double total_us = 0;
+    double total_error = 0;
+    double max_error = 0;
+    int runs = 0;
+};
+
+// Distance between two angles of a 60 degrees periodic shape
+static double angular_error(double a, double b)
+{
+    double d = std::fmod(std::fabs(a - b), 60.0);
+    return std::min(d, 60.0 - d);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <image_dir> <labels.csv> [repetitions]" << std::endl;
+        return 1;
+    }
+    std::string image_dir = argv[1];
+    int repetitions = (argc > 3) ? std::atoi(argv[3]) : 20;
+
+    std::ifstream labels(argv[2]);
+    if (!labels) {
+        std::cerr << "Could not open " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::vector<LabelledImage> images;
+    std::string line;
+    while (std::getline(labels, line)) {
+        std::stringstream ss(line);
+        std::string name;
+        std::string angle;
+        if (!std::getline(ss, name, ',') || !std::getline(ss, angle)) { continue; }
+        cv::Mat img = cv::imread(image_dir + "/" + name, cv::IMREAD_GRAYSCALE);
+        if (img.empty()) {
+            std::cerr << "Skipping unreadable image " << name << std::endl;
+            continue;
+        }
+        images.push_back({name, img, std::atof(angle.c_str())});
+    }
+    if (images.empty()) {
+        std::cerr << "No labelled image found" << std::endl;
+        return 1;
+    }
+
+    std::vector<EstimatorStats> estimators = {
+        {"hough", AngleEstimatorMode::HOUGH, false},
+        {"hough-par", AngleEstimatorMode::HOUGH, true},
+        {"polygon", AngleEstimatorMode::POLYGON, false},
+        {"poly-par", AngleEstimatorMode::POLYGON, true},
+    };
+
+    for (auto& stats : estimators) {
+        BoltAngleEstimator estimator(stats.mode);
+        estimator.set_parallel(stats.parallel);
+        for (const auto& image : images) {
+            double angle = 0;
+            auto t1 = std::chrono::steady_clock::now();
+            for (int i = 0; i < repetitions; i++) {
+                angle = estimator.find_rotation_angle(image.img);
+            }
+            auto t2 = std::chrono::steady_clock::now();
+
+            double error = angular_error(angle, image.angle);
+            stats.total_us += std::chrono::duration<double, std::micro>(t2 - t1).count() / repetitions;
+            stats.total_error += error;
+            stats.max_error = std::max(stats.max_error, error);
+            stats.runs++;
+        }
+    }
+
+    printf("%zu images, %d repetitions each\n\n", images.size(), repetitions);
+    printf("%-10s %14s %16s %15s\n", "estimator", "mean time [us]", "mean error [deg]", "max error [deg]");
+    for (const auto& stats : estimators) {
+        printf(
+            "%-10s %14.1f %16.2f %15.2f\n",
+            stats.name,
+            stats.total_us / stats.runs,
+            stats.total_error / stats.runs,
+            stats.max_error
+        );
+    }
+    return 0;
+}
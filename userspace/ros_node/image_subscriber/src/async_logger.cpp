@@ -0,0 +1,134 @@
+#include "async_logger.hpp"
+
+#include <chrono>
+#include <cstdarg>
+
+AsyncLogger::AsyncLogger(const rclcpp::Logger& rclcpp_logger, const std::string& file_path)
+: rclcpp_logger(rclcpp_logger),
+  file(nullptr),
+  ring(new Record[ASYNC_LOG_RING_SIZE]),
+  enqueue_pos(0),
+  dequeue_pos(0),
+  dropped_records(0),
+  running(true)
+{
+    static_assert((ASYNC_LOG_RING_SIZE & (ASYNC_LOG_RING_SIZE - 1)) == 0, "ASYNC_LOG_RING_SIZE must be a power of 2");
+
+    for (size_t i = 0; i < ASYNC_LOG_RING_SIZE; i++) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    if (!file_path.empty()) {
+        file = fopen(file_path.c_str(), "a");
+        if (file == nullptr) {
+            RCLCPP_ERROR(rclcpp_logger, "Could not open log file %s, logging to RCLCPP", file_path.c_str());
+        }
+    }
+
+    drain_thread = std::thread(&AsyncLogger::drain_loop, this);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    running.store(false, std::memory_order_release);
+    drain_thread.join();
+
+    if (dropped() > 0) {
+        RCLCPP_WARN(rclcpp_logger, "%lu log records were dropped (ring full)", (unsigned long)dropped());
+    }
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+// Bounded multi-producer ring (D. Vyukov): a slot is free for position pos when its sequence is pos,
+// and holds a record ready to be drained when its sequence is pos + 1
+void AsyncLogger::log(int level, const char* format, ...)
+{
+    Record* record;
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        record = &ring[pos & (ASYNC_LOG_RING_SIZE - 1)];
+        size_t sequence = record->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+        }
+        else if (diff < 0) {
+            dropped_records.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    record->stamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+    record->level = level;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(record->text, ASYNC_LOG_RECORD_LENGTH, format, args);
+    va_end(args);
+
+    record->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void AsyncLogger::drain_loop()
+{
+    while (running.load(std::memory_order_acquire)) {
+        if (!drain_one()) {
+            if (file != nullptr) { fflush(file); }
+            std::this_thread::sleep_for(std::chrono::milliseconds(ASYNC_LOG_DRAIN_PERIOD_MS));
+        }
+    }
+    // Flush what is left before exiting
+    while (drain_one()) {}
+    if (file != nullptr) { fflush(file); }
+}
+
+bool AsyncLogger::drain_one()
+{
+    Record& record = ring[dequeue_pos & (ASYNC_LOG_RING_SIZE - 1)];
+    if (record.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) { return false; }
+
+    write_record(record);
+
+    record.sequence.store(dequeue_pos + ASYNC_LOG_RING_SIZE, std::memory_order_release);
+    dequeue_pos++;
+    return true;
+}
+
+void AsyncLogger::write_record(const Record& record)
+{
+    if (file != nullptr) {
+        static const char* level_names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+        const char* level_name = (record.level >= 0 && record.level <= ASYNC_LOG_LEVEL_ERROR) ? level_names[record.level] : "?";
+        fprintf(
+            file,
+            "[%s] [%ld.%09ld] %s\n",
+            level_name,
+            (long)(record.stamp_ns / 1000000000),
+            (long)(record.stamp_ns % 1000000000),
+            record.text
+        );
+        return;
+    }
+
+    switch (record.level) {
+        case ASYNC_LOG_LEVEL_DEBUG:
+            RCLCPP_DEBUG(rclcpp_logger, "%s", record.text);
+            break;
+        case ASYNC_LOG_LEVEL_WARN:
+            RCLCPP_WARN(rclcpp_logger, "%s", record.text);
+            break;
+        case ASYNC_LOG_LEVEL_ERROR:
+            RCLCPP_ERROR(rclcpp_logger, "%s", record.text);
+            break;
+        default:
+            RCLCPP_INFO(rclcpp_logger, "%s", record.text);
+            break;
+    }
+}
@@ -0,0 +1,182 @@
+#include "bolt_angle.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+bool parse_angle_estimator_mode(const std::string& name, AngleEstimatorMode& mode)
+{
+    if (name == "hough") {
+        mode = AngleEstimatorMode::HOUGH;
+        return true;
+    }
+    if (name == "polygon") {
+        mode = AngleEstimatorMode::POLYGON;
+        return true;
+    }
+    return false;
+}
+
+void BoltAngleEstimator::reserve(cv::Size image_size)
+{
+    thresh.create(image_size, CV_8UC1);
+    contours.reserve(ANGLE_RESERVED_CONTOURS);
+    contour_areas.reserve(ANGLE_RESERVED_CONTOURS);
+    candidate_angles.reserve(ANGLE_RESERVED_CONTOURS);
+
+    size_t num_workers = parallel ? static_cast<size_t>(std::max(cv::getNumThreads(), 1)) : 1;
+    if (scratch.size() < num_workers) { scratch.resize(num_workers); }
+    for (AngleScratch& buffers : scratch) {
+        buffers.bolt_contour_buf.create(image_size, CV_8UC1);
+        buffers.edges_buf.create(image_size, CV_8UC1);
+        buffers.lines.reserve(ANGLE_RESERVED_POINTS);
+        buffers.polygon.reserve(ANGLE_RESERVED_POINTS);
+    }
+}
+
+double BoltAngleEstimator::find_rotation_angle(const cv::Mat& img_grayscale)
+{
+    cv::threshold(img_grayscale, thresh, 94, 500, cv::THRESH_BINARY_INV);
+
+    contours.clear();
+    cv::findContours(thresh, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+    if (contours.empty()) { return 0.0; }
+
+    // Largest contours first, each area being computed only once
+    contour_areas.clear();
+    for (size_t i = 0; i < contours.size(); i++) {
+        contour_areas.emplace_back(cv::contourArea(contours[i]), i);
+    }
+    std::sort(contour_areas.begin(), contour_areas.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+
+    return parallel ? find_angle_parallel() : find_angle_sequential();
+}
+
+// Angle of the candidate contour of the given rank in contour_areas
+bool BoltAngleEstimator::candidate_angle(size_t rank, AngleScratch& buffers, double& angle)
+{
+    const auto& contour = contours[contour_areas[rank].second];
+    if (mode == AngleEstimatorMode::HOUGH) {
+        return hough_angle(contour, buffers, angle);
+    }
+    return polygon_angle(contour, buffers, angle);
+}
+
+double BoltAngleEstimator::find_angle_sequential()
+{
+    if (scratch.empty()) { scratch.resize(1); }
+
+    double angle = 0.0;
+    for (size_t rank = 0; rank < contour_areas.size(); rank++) {
+        if (candidate_angle(rank, scratch[0], angle)) { return angle; }
+    }
+    return 0.0;
+}
+
+// Every worker takes the candidates of rank w, w + num_workers, ... so that the largest contours are
+// evaluated first. Once a candidate succeeds, the candidates of higher rank are skipped, while the
+// lower ranks still running can replace it: the result is the same as the sequential search.
+double BoltAngleEstimator::find_angle_parallel()
+{
+    const size_t num_candidates = contour_areas.size();
+    const size_t num_workers = std::min(num_candidates, static_cast<size_t>(std::max(cv::getNumThreads(), 1)));
+    if (num_workers <= 1) { return find_angle_sequential(); }
+
+    if (scratch.size() < num_workers) { scratch.resize(num_workers); }
+    candidate_angles.resize(num_candidates);
+    std::atomic<size_t> best_rank(num_candidates);
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(num_workers)), [&](const cv::Range& range) {
+        for (int worker = range.start; worker < range.end; worker++) {
+            for (size_t rank = worker; rank < best_rank.load(std::memory_order_acquire); rank += num_workers) {
+                if (!candidate_angle(rank, scratch[worker], candidate_angles[rank])) { continue; }
+
+                size_t current = best_rank.load(std::memory_order_acquire);
+                while (rank < current && !best_rank.compare_exchange_weak(current, rank, std::memory_order_acq_rel)) {}
+                break;
+            }
+        }
+    }, static_cast<double>(num_workers));
+
+    size_t rank = best_rank.load();
+    return (rank < num_candidates) ? candidate_angles[rank] : 0.0;
+}
+
+// Canny filter impelmentation to get the angle of a bole / screw
+bool BoltAngleEstimator::hough_angle(const std::vector<cv::Point>& contour, AngleScratch& buffers, double& angle)
+{
+    // Full frame scratch buffers, only the top-left ROI sized part is used per candidate
+    buffers.bolt_contour_buf.create(thresh.size(), CV_8UC1);
+    buffers.edges_buf.create(thresh.size(), CV_8UC1);
+
+    // Bounding box of the contour with a margin so that Canny still sees its border
+    cv::Rect roi = cv::boundingRect(contour);
+    roi.x -= ANGLE_ROI_MARGIN;
+    roi.y -= ANGLE_ROI_MARGIN;
+    roi.width += 2 * ANGLE_ROI_MARGIN;
+    roi.height += 2 * ANGLE_ROI_MARGIN;
+    roi &= cv::Rect(cv::Point(0, 0), thresh.size());
+
+    cv::Mat bolt_contour_img = buffers.bolt_contour_buf(cv::Rect(cv::Point(0, 0), roi.size()));
+    cv::Mat edges = buffers.edges_buf(cv::Rect(cv::Point(0, 0), roi.size()));
+
+    bolt_contour_img.setTo(0);
+    const cv::Point* points = contour.data();
+    int num_points = static_cast<int>(contour.size());
+    cv::fillPoly(bolt_contour_img, &points, &num_points, 1, 255, cv::LINE_8, 0, -roi.tl());
+
+    cv::Canny(bolt_contour_img, edges, 50, 100);
+
+    std::vector<cv::Vec2f>& lines = buffers.lines;
+    lines.clear();
+    cv::HoughLines(edges, lines, 1, CV_PI / 60, 30);
+
+    if (lines.size() < 2 || lines.size() > 6) { return false; }
+
+    // theta is already in [0, pi[, so its conversion to degrees needs no atan2.
+    // The first line within [0, 60] wins, otherwise the last one is folded modulo 60.
+    float line_angle = 0;
+    for (const auto& line : lines) {
+        line_angle = line[1] * static_cast<float>(180.0 / CV_PI);
+        if (line_angle <= 60) {
+            angle = line_angle;
+            return true;
+        }
+    }
+    angle = static_cast<uint32_t>(line_angle) % 60;
+    return true;
+}
+
+// Hexagon orientation straight from the contour, without rasterizing it
+bool BoltAngleEstimator::polygon_angle(const std::vector<cv::Point>& contour, AngleScratch& buffers, double& angle)
+{
+    std::vector<cv::Point>& polygon = buffers.polygon;
+    double perimeter = cv::arcLength(contour, true);
+    cv::approxPolyDP(contour, polygon, ANGLE_POLYGON_EPSILON * perimeter, true);
+
+    // Not hexagon-like enough (a vertex can be lost or split by the approximation)
+    if (polygon.size() < 5 || polygon.size() > 7) { return false; }
+
+    // Length weighted circular mean of the edge normals, with the 60 degrees period mapped to a full turn.
+    // The normal (and not the edge direction) is used to match the theta returned by HoughLines.
+    double sum_x = 0;
+    double sum_y = 0;
+    for (size_t i = 0; i < polygon.size(); i++) {
+        const cv::Point& a = polygon[i];
+        const cv::Point& b = polygon[(i + 1) % polygon.size()];
+        double dx = b.x - a.x;
+        double dy = b.y - a.y;
+        double length = std::sqrt(dx * dx + dy * dy);
+        double normal = std::atan2(dy, dx) + CV_PI / 2;
+        sum_x += length * std::cos(6 * normal);
+        sum_y += length * std::sin(6 * normal);
+    }
+    if (sum_x == 0 && sum_y == 0) { return false; }
+
+    angle = std::atan2(sum_y, sum_x) / 6 * 180.0 / CV_PI;
+    if (angle < 0) { angle += 60; }
+    return true;
+}
@@ -0,0 +1,463 @@
+// Offline replay benchmark of image_subscriber_node: recorded frames in, throughput / latency / CPU report out,
+// without camera, motors or board.
+//
+// Usage:
+// $ ros2 run image_subscriber image_subscriber_node --ros-args -p fpga_inference:=false -p continuous_mode:=true \
+//       -p motion_gating:=false -p frame_diff_threshold:=0.0
+// $ ros2 run image_subscriber image_replay --ros-args -p frames_dir:=<dir> [-p width:=640] [-p height:=480] \
+//       [-p rate_hz:=0.0] [-p frame_count:=1000] [-p report_file:=<csv>]
+//
+// Frames are the raw YUYV files of frames_dir (width * height * 2 bytes each, in name order), loaded once and
+// published in a loop on /image_raw, stamped when published. rate_hz 0 replays as fast as the node goes: the next
+// frame is published as soon as the trace of the previous one arrived, or after response_timeout_ms for a frame
+// the node did not trace (dropped while a motor moved, unchanged, part done...).
+// A rosbag2 recording can be replayed instead with `ros2 bag play` and publish_frames:=false, this tool then only
+// runs the stand-ins and the measurements (until frame_count traces).
+//
+// The tool stands in for read_write_node: SetPosition commands are acknowledged (MotorWriteAck) after
+// motor_write_delay_ms, the time of a servo write, and get_position returns the last commanded position. With
+// fpga_inference:=false the node runs the network on its CPU workers instead of the IP core.
+//
+// Reported from the frame_trace topic of the node: frames per second, percentiles of the stage times and
+// latencies, and the CPU usage of the node process (found by name in /proc) over the replay.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/msg/image.hpp>
+
+#include "dynamixel_sdk_custom_interfaces/msg/frame_trace.hpp"
+#include "dynamixel_sdk_custom_interfaces/msg/motor_write_ack.hpp"
+#include "dynamixel_sdk_custom_interfaces/msg/set_position.hpp"
+#include "dynamixel_sdk_custom_interfaces/srv/get_position.hpp"
+
+#define REPLAY_PROC_COMM_LENGTH 15 // Process names are truncated to this in /proc/<pid>/comm
+
+using FrameTrace = dynamixel_sdk_custom_interfaces::msg::FrameTrace;
+using MotorWriteAck = dynamixel_sdk_custom_interfaces::msg::MotorWriteAck;
+using SetPosition = dynamixel_sdk_custom_interfaces::msg::SetPosition;
+using GetPosition = dynamixel_sdk_custom_interfaces::srv::GetPosition;
+
+// Samples of one reported metric, in microseconds
+struct MetricSamples {
+    const char* name;
+    std::vector<double> samples;
+};
+
+// Nearest rank percentile of sorted samples
+static double percentile(std::vector<double>& samples, double p)
+{
+    size_t index = std::min(samples.size() - 1, (size_t)(p / 100.0 * samples.size()));
+    return samples[index];
+}
+
+// CPU time (user + system) of a process in seconds, -1 if it cannot be read
+static double process_cpu_s(pid_t pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) { return -1; }
+    char line[1024];
+    char* read = fgets(line, sizeof(line), file);
+    fclose(file);
+    if (read == nullptr) { return -1; }
+
+    // The name (field 2) can contain spaces, the fields are counted from the closing parenthesis: state is
+    // field 3, utime 14 and stime 15
+    char* fields = strrchr(line, ')');
+    if (fields == nullptr) { return -1; }
+    unsigned long utime = 0;
+    unsigned long stime = 0;
+    if (sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2) { return -1; }
+    return (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+// First process whose name matches (truncated like /proc/<pid>/comm), 0 if none
+static pid_t find_process(const std::string& name)
+{
+    std::string comm_name = name.substr(0, REPLAY_PROC_COMM_LENGTH);
+    DIR* proc = opendir("/proc");
+    if (proc == nullptr) { return 0; }
+    pid_t found = 0;
+    while (struct dirent* entry = readdir(proc)) {
+        pid_t pid = (pid_t)atoi(entry->d_name);
+        if (pid <= 0) { continue; }
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/comm", (int)pid);
+        FILE* file = fopen(path, "r");
+        if (file == nullptr) { continue; }
+        char comm[64] = "";
+        if (fgets(comm, sizeof(comm), file) != nullptr) {
+            comm[strcspn(comm, "\n")] = '\0';
+        }
+        fclose(file);
+        if (comm_name == comm) {
+            found = pid;
+            break;
+        }
+    }
+    closedir(proc);
+    return found;
+}
+
+static double self_cpu_s()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+class ImageReplay : public rclcpp::Node
+{
+    public:
+        ImageReplay() : Node("image_replay") {
+            this->declare_parameter("frames_dir", std::string(""));
+            this->declare_parameter("width", 640);
+            this->declare_parameter("height", 480);
+            this->declare_parameter("publish_frames", true);
+            this->declare_parameter("rate_hz", 0.0);
+            this->declare_parameter("frame_count", 1000);
+            this->declare_parameter("response_timeout_ms", 100);
+            this->declare_parameter("motor_write_delay_ms", 0);
+            this->declare_parameter("node_process", std::string("image_subscriber_node"));
+            this->declare_parameter("report_file", std::string(""));
+            std::string frames_dir;
+            double rate_hz = 0;
+            int response_timeout_ms = 100;
+            int motor_write_delay_ms = 0;
+            this->get_parameter("frames_dir", frames_dir);
+            this->get_parameter("width", width);
+            this->get_parameter("height", height);
+            this->get_parameter("publish_frames", publish_frames);
+            this->get_parameter("rate_hz", rate_hz);
+            this->get_parameter("frame_count", frame_count);
+            this->get_parameter("response_timeout_ms", response_timeout_ms);
+            this->get_parameter("motor_write_delay_ms", motor_write_delay_ms);
+            this->get_parameter("node_process", node_process);
+            this->get_parameter("report_file", report_file);
+            response_timeout = std::chrono::milliseconds(std::max(response_timeout_ms, 1));
+            motor_write_delay = std::chrono::milliseconds(std::max(motor_write_delay_ms, 0));
+            closed_loop = (rate_hz <= 0);
+
+            if (publish_frames && !load_frames(frames_dir)) {
+                RCLCPP_ERROR(this->get_logger(), "No %dx%d YUYV frame in '%s'", width, height, frames_dir.c_str());
+                rclcpp::shutdown();
+                return;
+            }
+
+            metrics = {
+                {"receive_latency", {}},
+                {"preprocess", {}},
+                {"inference", {}},
+                {"angle", {}},
+                {"publish", {}},
+                {"callback_latency", {}},
+                {"publish_latency", {}},
+                {"motor_latency", {}}
+            };
+            for (MetricSamples& metric : metrics) {
+                metric.samples.reserve(frame_count);
+            }
+
+            // Stand-in of read_write_node
+            motor_write_ack_publisher_ = this->create_publisher<MotorWriteAck>("motor_write_ack", 10);
+            set_position_subscriber_ = this->create_subscription<SetPosition>(
+                "set_position",
+                10,
+                std::bind(&ImageReplay::on_set_position, this, std::placeholders::_1)
+            );
+            get_position_server_ = this->create_service<GetPosition>(
+                "get_position",
+                [this](const std::shared_ptr<GetPosition::Request> request, std::shared_ptr<GetPosition::Response> response) {
+                    response->position = motor_positions[request->id];
+                }
+            );
+
+            trace_subscriber_ = this->create_subscription<FrameTrace>(
+                "frame_trace",
+                100,
+                std::bind(&ImageReplay::on_frame_trace, this, std::placeholders::_1)
+            );
+
+            node_pid = find_process(node_process);
+            if (node_pid == 0) {
+                RCLCPP_WARN(this->get_logger(), "Process '%s' not found, no CPU usage report", node_process.c_str());
+            }
+
+            if (publish_frames) {
+                image_publisher_ = this->create_publisher<sensor_msgs::msg::Image>("/image_raw", 10);
+                // Closed loop: the timer only covers the frames the node does not trace
+                auto period = closed_loop ?
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(response_timeout) :
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(1.0 / rate_hz));
+                frame_timer_ = this->create_wall_timer(period, std::bind(&ImageReplay::on_timer, this));
+                RCLCPP_INFO(
+                    this->get_logger(),
+                    "Replaying %zu frame(s) of %s, %d in total, %s",
+                    frames.size(),
+                    frames_dir.c_str(),
+                    frame_count,
+                    closed_loop ? "as fast as the node goes" : "at a fixed rate"
+                );
+            }
+        }
+
+    private:
+        rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr image_publisher_;
+        rclcpp::Publisher<MotorWriteAck>::SharedPtr motor_write_ack_publisher_;
+        rclcpp::Subscription<SetPosition>::SharedPtr set_position_subscriber_;
+        rclcpp::Service<GetPosition>::SharedPtr get_position_server_;
+        rclcpp::Subscription<FrameTrace>::SharedPtr trace_subscriber_;
+        rclcpp::TimerBase::SharedPtr frame_timer_;
+
+        int width = 640;
+        int height = 480;
+        bool publish_frames = true;
+        bool closed_loop = true;
+        int frame_count = 1000;
+        std::chrono::milliseconds response_timeout;
+        std::chrono::milliseconds motor_write_delay;
+        std::string node_process;
+        std::string report_file;
+        std::vector<std::vector<uint8_t>> frames;
+        std::map<uint8_t, int32_t> motor_positions;
+
+        // Replay progress
+        int frames_published = 0;
+        int traces_received = 0;
+        bool started = false;
+        bool finished = false;
+        std::chrono::steady_clock::time_point start_time;
+        std::chrono::steady_clock::time_point last_publish_time;
+        std::chrono::steady_clock::time_point last_trace_time;
+        pid_t node_pid = 0;
+        double node_cpu_start_s = 0;
+        double self_cpu_start_s = 0;
+        uint64_t motor_commands = 0;
+        std::vector<MetricSamples> metrics;
+
+        bool load_frames(const std::string& dir)
+        {
+            struct dirent** entries;
+            int count = scandir(dir.c_str(), &entries, nullptr, alphasort);
+            if (count < 0) { return false; }
+
+            const size_t frame_size = (size_t)width * height * 2;
+            for (int i = 0; i < count; i++) {
+                std::string path = dir + "/" + entries[i]->d_name;
+                free(entries[i]);
+                FILE* file = fopen(path.c_str(), "rb");
+                if (file == nullptr) { continue; }
+                std::vector<uint8_t> frame(frame_size);
+                size_t read = fread(frame.data(), 1, frame_size, file);
+                bool exact_size = (read == frame_size) && (fgetc(file) == EOF);
+                fclose(file);
+                if (exact_size) {
+                    frames.push_back(std::move(frame));
+                }
+                else if (read > 0) {
+                    RCLCPP_WARN(this->get_logger(), "Skipping %s: not a %dx%d YUYV frame", path.c_str(), width, height);
+                }
+            }
+            free(entries);
+            return !frames.empty();
+        }
+
+        void start()
+        {
+            started = true;
+            start_time = std::chrono::steady_clock::now();
+            last_trace_time = start_time;
+            node_cpu_start_s = (node_pid != 0) ? process_cpu_s(node_pid) : -1;
+            self_cpu_start_s = self_cpu_s();
+        }
+
+        void publish_next_frame()
+        {
+            if (!started) { start(); }
+
+            sensor_msgs::msg::Image msg;
+            msg.header.stamp = this->now();
+            msg.header.frame_id = "replay";
+            msg.width = width;
+            msg.height = height;
+            msg.encoding = "yuv422_yuy2";
+            msg.step = width * 2;
+            msg.data = frames[frames_published % frames.size()];
+            image_publisher_->publish(msg);
+            frames_published++;
+            last_publish_time = std::chrono::steady_clock::now();
+        }
+
+        void on_timer()
+        {
+            if (finished) { return; }
+
+            auto now = std::chrono::steady_clock::now();
+            if (frames_published >= frame_count) {
+                // Last traces
+                if (traces_received >= frames_published || now - last_publish_time >= response_timeout) { finish(); }
+                return;
+            }
+            // Closed loop: the last frame was not traced in time
+            if (closed_loop && frames_published > 0 && now - last_publish_time < response_timeout) { return; }
+            if (image_publisher_->get_subscription_count() == 0) { return; } // Node not up yet
+            publish_next_frame();
+        }
+
+        void on_set_position(const SetPosition::SharedPtr msg)
+        {
+            rclcpp::Time received = this->now();
+            // Blocking like the serial write of read_write_node
+            if (motor_write_delay.count() > 0) {
+                std::this_thread::sleep_for(motor_write_delay);
+            }
+            motor_positions[msg->id] = msg->position;
+            motor_commands++;
+
+            MotorWriteAck ack;
+            ack.id = msg->id;
+            ack.position = msg->position;
+            ack.trace_id = msg->trace_id;
+            ack.received = received;
+            ack.written = this->now();
+            ack.comm_result = 0;
+            ack.dxl_error = 0;
+            motor_write_ack_publisher_->publish(ack);
+        }
+
+        void on_frame_trace(const FrameTrace::SharedPtr msg)
+        {
+            if (finished) { return; }
+            if (!started) { start(); } // Frames published by another tool
+
+            const float values[] = {
+                msg->receive_latency_us,
+                msg->preprocess_us,
+                msg->inference_us,
+                msg->angle_us,
+                msg->publish_us,
+                msg->callback_latency_us,
+                msg->publish_latency_us,
+                msg->motor_write_latency_us
+            };
+            // Stages that did not run are not samples
+            for (size_t i = 0; i < metrics.size(); i++) {
+                if (values[i] > 0) { metrics[i].samples.push_back(values[i]); }
+            }
+            traces_received++;
+            last_trace_time = std::chrono::steady_clock::now();
+
+            if (!publish_frames) {
+                if (traces_received >= frame_count) { finish(); }
+                return;
+            }
+            if (closed_loop && frames_published < frame_count) {
+                publish_next_frame();
+            }
+        }
+
+        void finish()
+        {
+            finished = true;
+            frame_timer_.reset();
+
+            double elapsed_s = std::chrono::duration<double>(last_trace_time - start_time).count();
+            double node_cpu_s = (node_pid != 0) ? process_cpu_s(node_pid) - node_cpu_start_s : -1;
+            double replay_cpu_s = self_cpu_s() - self_cpu_start_s;
+            double fps = (elapsed_s > 0) ? traces_received / elapsed_s : 0;
+
+            printf(
+                "%d frame(s) published, %d traced in %.2f s: %.1f fps, %lu motor command(s)\n",
+                frames_published,
+                traces_received,
+                elapsed_s,
+                fps,
+                (unsigned long)motor_commands
+            );
+            if (node_cpu_s >= 0 && elapsed_s > 0) {
+                printf(
+                    "CPU: %s %.1f%%, replay %.1f%% (of one core, %ld core(s))\n",
+                    node_process.c_str(),
+                    100.0 * node_cpu_s / elapsed_s,
+                    100.0 * replay_cpu_s / elapsed_s,
+                    sysconf(_SC_NPROCESSORS_ONLN)
+                );
+            }
+
+            FILE* report = report_file.empty() ? nullptr : fopen(report_file.c_str(), "w");
+            if (report != nullptr) {
+                fprintf(report, "metric,samples,mean_us,p50_us,p90_us,p99_us,max_us\n");
+                fprintf(report, "fps,%d,%.2f,,,,\n", traces_received, fps);
+                if (node_cpu_s >= 0 && elapsed_s > 0) {
+                    fprintf(report, "node_cpu_percent,,%.1f,,,,\n", 100.0 * node_cpu_s / elapsed_s);
+                }
+            }
+
+            printf("%-16s %8s %9s %9s %9s %9s %9s\n", "(us)", "samples", "mean", "p50", "p90", "p99", "max");
+            for (MetricSamples& metric : metrics) {
+                std::vector<double>& samples = metric.samples;
+                if (samples.empty()) {
+                    printf("%-16s %8d\n", metric.name, 0);
+                    continue;
+                }
+                std::sort(samples.begin(), samples.end());
+                double sum = 0;
+                for (double sample : samples) {
+                    sum += sample;
+                }
+                double mean = sum / samples.size();
+                printf(
+                    "%-16s %8zu %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+                    metric.name,
+                    samples.size(),
+                    mean,
+                    percentile(samples, 50),
+                    percentile(samples, 90),
+                    percentile(samples, 99),
+                    samples.back()
+                );
+                if (report != nullptr) {
+                    fprintf(
+                        report,
+                        "%s,%zu,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+                        metric.name,
+                        samples.size(),
+                        mean,
+                        percentile(samples, 50),
+                        percentile(samples, 90),
+                        percentile(samples, 99),
+                        samples.back()
+                    );
+                }
+            }
+            if (report != nullptr) {
+                fclose(report);
+            }
+            fflush(stdout);
+            rclcpp::shutdown();
+        }
+};
+
+int main(int argc, char *argv[])
+{
+    rclcpp::init(argc, argv);
+    auto node = std::make_shared<ImageReplay>();
+    if (rclcpp::ok()) {
+        rclcpp::spin(node);
+    }
+    rclcpp::shutdown();
+    return 0;
+}
@@ -1,22 +1,38 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <cv_bridge/cv_bridge.h>
-#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 #include <opencv2/opencv.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <sensor_msgs/msg/image.hpp>
 
 #include "dynamixel_sdk/dynamixel_sdk.h"
+#include "dynamixel_sdk_custom_interfaces/msg/frame_trace.hpp"
+#include "dynamixel_sdk_custom_interfaces/msg/motor_write_ack.hpp"
 #include "dynamixel_sdk_custom_interfaces/msg/set_position.hpp"
+#include "dynamixel_sdk_custom_interfaces/srv/get_position.hpp"
+#include "alloc_counter.hpp"
+#include "async_logger.hpp"
+#include "bolt_angle.hpp"
+#include "frame_change_detector.hpp"
+#include "inference_gate.hpp"
+#include "frame_workspace.hpp"
+#include "inference_scheduler.hpp"
+#include "latency_tracer.hpp"
+#include "realtime.hpp"
+#include "motor_settle_tracker.hpp"
+#include "rotation_search.hpp"
 #include "xnn_inference.h"
 
 #define ROTATION_MOTOR_ID 1
 #define ANGLE_MOTOR_ID 0
 
-#define RESIZED_IMG_WIDTH 20
-#define RESIZED_IMG_HEIGHT 15
-
 #define ROTATION_MOTOR_INIT_POS 400
 #define ROTATION_MOTOR_MAX_POS 0
-#define ROTATION_MOTOR_STEP (-1)
 
 #define ANGLE_MOTOR_INIT_POS 512
 
@@ -24,8 +40,18 @@
 
 #define NN_CORRECT_LABEL 1 // Hexagonal bolt
 
-// Canny filter to get the rotation angle of a screw / bolt
-double find_rotation_angle(const cv::Mat& input_img);
+#define FRAME_STATS_PERIOD 100 // Frames between two inference / skip counters reports
+#define ALLOC_WARMUP_FRAMES 10 // Inferences after which the inference path must not allocate (debug builds)
+
+// Operating states, a part goes through SEARCH -> ORIENT, then RESET -> WAIT_PART -> SEARCH for the next part
+// in continuous mode, or DONE otherwise
+enum class NodeState {
+    SEARCH,    // Rotating the camera until the NN finds the bolt
+    ORIENT,    // Bolt locked, waiting for the angle motor to reach the bolt angle
+    RESET,     // Homing both motors
+    WAIT_PART, // Motors home, waiting for the scene to change (next part)
+    DONE       // Single-shot mode, the part is done
+};
 
 class ImageSubscriber : public rclcpp::Node
 {
@@ -33,18 +59,177 @@ class ImageSubscriber : public rclcpp::Node
         ImageSubscriber() : Node("image_subscriber") {
             RCLCPP_INFO(this->get_logger(), "Initializing ImageSubscriber node");
 
-            int status = XNn_inference_Initialize(&ip_inst, "nn_inference");
-            if (status != XST_SUCCESS) {
-                RCLCPP_INFO(this->get_logger(), "Error: Could not initialize the IP core.");
+            // Per-frame messages go through the asynchronous logger, to this file if set, to RCLCPP otherwise
+            this->declare_parameter("log_file", std::string(""));
+            std::string log_file;
+            this->get_parameter("log_file", log_file);
+            logger = std::make_unique<AsyncLogger>(this->get_logger(), log_file);
+
+            // "hough" (Canny + HoughLines) or "polygon" (contour polygon approximation)
+            this->declare_parameter("angle_estimator", std::string("hough"));
+            std::string angle_estimator_name;
+            this->get_parameter("angle_estimator", angle_estimator_name);
+            AngleEstimatorMode angle_estimator_mode;
+            if (!parse_angle_estimator_mode(angle_estimator_name, angle_estimator_mode)) {
+                RCLCPP_INFO(this->get_logger(), "Unknown angle estimator '%s', using hough", angle_estimator_name.c_str());
+                angle_estimator_mode = AngleEstimatorMode::HOUGH;
+            }
+            angle_estimator.set_mode(angle_estimator_mode);
+
+            // Evaluate the candidate contours of find_rotation_angle on all the cores
+            this->declare_parameter("angle_parallel", true);
+            bool angle_parallel = true;
+            this->get_parameter("angle_parallel", angle_parallel);
+            angle_estimator.set_parallel(angle_parallel);
+
+            // Mean absolute luma difference (0 - 255) under which a frame is considered unchanged while the
+            // rotation motor is settled and was not commanded since the last inference, in which case the last
+            // prediction is reused (0 disables the gate). Without motion gating, it saves the inferences of the
+            // frames seen between the arrival of the motor and the end of its settle delay.
+            double frame_diff_threshold = 2.0;
+            this->declare_parameter("frame_diff_threshold", frame_diff_threshold);
+            this->get_parameter("frame_diff_threshold", frame_diff_threshold);
+            this->declare_parameter("frame_diff_step", FRAME_DIFF_DEFAULT_STEP);
+            int frame_diff_step = FRAME_DIFF_DEFAULT_STEP;
+            this->get_parameter("frame_diff_step", frame_diff_step);
+            inference_gate = InferenceGate(frame_diff_threshold, frame_diff_step);
+
+            // Steps of the rotation search, e.g. [32, 8, 1] for a coarse-to-fine search ([1]: one step per frame)
+            this->declare_parameter("search_step_plan", std::vector<int64_t>{1});
+            std::vector<int64_t> search_step_plan_param;
+            this->get_parameter("search_step_plan", search_step_plan_param);
+            std::vector<int> search_step_plan(search_step_plan_param.begin(), search_step_plan_param.end());
+            rotation_search = make_rotation_search(ROTATION_MOTOR_INIT_POS, ROTATION_MOTOR_MAX_POS, search_step_plan);
+
+            // Only run inference on frames captured once the rotation motor reached its commanded position
+            // (read back through the get_position service, or assumed after settle_timeout_ms)
+            this->declare_parameter("motion_gating", true);
+            this->get_parameter("motion_gating", motion_gating);
+            this->declare_parameter("position_tolerance", 2);
+            this->declare_parameter("settle_delay_ms", 30);
+            this->declare_parameter("settle_timeout_ms", 500);
+            int position_tolerance = 2;
+            int settle_delay_ms = 30;
+            int settle_timeout_ms = 500;
+            this->get_parameter("position_tolerance", position_tolerance);
+            this->get_parameter("settle_delay_ms", settle_delay_ms);
+            this->get_parameter("settle_timeout_ms", settle_timeout_ms);
+            MotorSettleTracker settle_tracker(
+                position_tolerance,
+                (int64_t)settle_delay_ms * 1000000,
+                (int64_t)settle_timeout_ms * 1000000
+            );
+            rotation_motor = {ROTATION_MOTOR_ID, settle_tracker, false};
+            angle_motor = {ANGLE_MOTOR_ID, settle_tracker, false};
+
+            // Continuous mode: after a part is oriented, home the motors and wait for the next part (a scene
+            // change of at least part_change_threshold, mean absolute luma difference) instead of stopping
+            this->declare_parameter("continuous_mode", false);
+            this->get_parameter("continuous_mode", continuous_mode);
+            this->declare_parameter("part_change_threshold", 10.0);
+            this->get_parameter("part_change_threshold", part_change_threshold);
+            part_detector = FrameChangeDetector(frame_diff_step);
+
+            // "scan": whole frame inference only, "multi_crop": the frame is also tiled into crop_count overlapping
+            // crops (crop_width_ratio of the frame width each), and the rotation motor is moved straight to the
+            // crop(s) where the bolt was found
+            this->declare_parameter("search_mode", std::string("scan"));
+            std::string search_mode;
+            this->get_parameter("search_mode", search_mode);
+            multi_crop = (search_mode == "multi_crop");
+            this->declare_parameter("crop_count", 5);
+            this->get_parameter("crop_count", crop_count);
+            crop_count = std::min(std::max(crop_count, 1), NN_INPUT_BUFFERS - 1);
+            this->declare_parameter("crop_width_ratio", 0.4);
+            this->get_parameter("crop_width_ratio", crop_width_ratio);
+            crop_width_ratio = std::min(std::max(crop_width_ratio, 0.05), 1.0);
+            // Horizontal image shift per rotation motor unit (negative if the image moves the other way)
+            this->declare_parameter("pixels_per_rotation_unit", 3.0);
+            this->get_parameter("pixels_per_rotation_unit", pixels_per_rotation_unit);
+            if (pixels_per_rotation_unit == 0) { pixels_per_rotation_unit = 3.0; }
+            crop_offset = 0;
+
+            // Per-frame latency traces (camera stamp -> stages -> SetPosition -> servo write), published on
+            // frame_trace and written to trace_csv_file / trace_chrome_file (chrome://tracing) when set.
+            // Frames whose camera-to-servo-write latency exceeds latency_slo_ms are reported (0: no SLO).
+            this->declare_parameter("trace", true);
+            this->declare_parameter("trace_csv_file", std::string(""));
+            this->declare_parameter("trace_chrome_file", std::string(""));
+            this->declare_parameter("latency_slo_ms", 0.0);
+            bool trace = true;
+            std::string trace_csv_file;
+            std::string trace_chrome_file;
+            double latency_slo_ms = 0;
+            this->get_parameter("trace", trace);
+            this->get_parameter("trace_csv_file", trace_csv_file);
+            this->get_parameter("trace_chrome_file", trace_chrome_file);
+            this->get_parameter("latency_slo_ms", latency_slo_ms);
+            latency_slo_ns = (int64_t)(latency_slo_ms * 1e6);
+            slo_violations = 0;
+            tracer = std::make_unique<LatencyTracer>(trace_csv_file, trace_chrome_file);
+            tracer->set_enabled(trace);
+            tracer->set_completion_callback(std::bind(&ImageSubscriber::on_frame_trace, this, std::placeholders::_1));
+
+            // Real-time mode (applied by main): the executor runs on its own thread pinned to rt_cpus (isolated
+            // cores) with SCHED_FIFO priority rt_priority, and the process memory is locked and prefaulted.
+            // The inference workers the executor waits for get the same settings (applied here).
+            this->declare_parameter("realtime", false);
+            this->declare_parameter("rt_cpus", std::vector<int64_t>{});
+            this->declare_parameter("rt_priority", RT_DEFAULT_PRIORITY);
+            this->declare_parameter("rt_prefault_mb", RT_DEFAULT_PREFAULT_MB);
+            std::vector<int64_t> rt_cpus;
+            int rt_prefault_mb = RT_DEFAULT_PREFAULT_MB;
+            this->get_parameter("realtime", realtime);
+            this->get_parameter("rt_cpus", rt_cpus);
+            this->get_parameter("rt_priority", realtime_config.priority);
+            this->get_parameter("rt_prefault_mb", rt_prefault_mb);
+            realtime_config.cpus.assign(rt_cpus.begin(), rt_cpus.end());
+            realtime_config.prefault_heap_bytes = (size_t)std::max(rt_prefault_mb, 0) * 1024 * 1024;
+
+            // Inferences are dispatched to the IP core and to cpu_inference_workers threads running the same
+            // network on the CPU, which also take over when the IP core is unavailable or disabled
+            // (fpga_inference false, e.g. for an offline replay)
+            this->declare_parameter("cpu_inference_workers", 1);
+            this->declare_parameter("fpga_inference", true);
+            int cpu_inference_workers = 1;
+            bool fpga_inference = true;
+            this->get_parameter("cpu_inference_workers", cpu_inference_workers);
+            this->get_parameter("fpga_inference", fpga_inference);
+            int status = XST_DEVICE_NOT_FOUND;
+            if (fpga_inference) {
+                status = XNn_inference_Initialize(&ip_inst, "nn_inference");
+                if (status != XST_SUCCESS) {
+                    RCLCPP_INFO(this->get_logger(), "Error: Could not initialize the IP core.");
+                }
+            }
+            scheduler = std::make_unique<InferenceScheduler>(
+                (status == XST_SUCCESS) ? &ip_inst : nullptr,
+                std::max(cpu_inference_workers, 0),
+                realtime ? &realtime_config : nullptr
+            );
+            if (!scheduler->realtime_error().empty()) {
+                RCLCPP_WARN(this->get_logger(), "Could not configure the real-time inference workers: %s", scheduler->realtime_error().c_str());
+            }
+            if (!scheduler->has_backends()) {
+                RCLCPP_INFO(this->get_logger(), "Error: No inference backend (IP core unavailable and no CPU worker).");
                 return;
             }
 
-            current_rotation_motor_angle = ROTATION_MOTOR_INIT_POS;
+            current_rotation_motor_angle = rotation_search->reset();
             current_angle_motor_angle = ANGLE_MOTOR_INIT_POS;
 
             motor_publisher_ = this->create_publisher<dynamixel_sdk_custom_interfaces::msg::SetPosition>("set_position", 10);
+            position_client_ = this->create_client<dynamixel_sdk_custom_interfaces::srv::GetPosition>("get_position");
+            trace_publisher_ = this->create_publisher<dynamixel_sdk_custom_interfaces::msg::FrameTrace>("frame_trace", 10);
+            motor_write_ack_subscription_ = this->create_subscription<dynamixel_sdk_custom_interfaces::msg::MotorWriteAck>(
+                "motor_write_ack",
+                10,
+                [this](const dynamixel_sdk_custom_interfaces::msg::MotorWriteAck::SharedPtr ack) {
+                    tracer->motor_written(ack->trace_id, rclcpp::Time(ack->written).nanoseconds());
+                }
+            );
 
-            set_motor_position(ROTATION_MOTOR_ID, ROTATION_MOTOR_INIT_POS);
+            set_motor_position(ROTATION_MOTOR_ID, current_rotation_motor_angle);
             set_motor_position(ANGLE_MOTOR_ID, ANGLE_MOTOR_INIT_POS);
 
             camera_subscription_ = this->create_subscription<sensor_msgs::msg::Image>(
@@ -53,44 +238,329 @@ class ImageSubscriber : public rclcpp::Node
                 std::bind(&ImageSubscriber::onImageMsg, this, std::placeholders::_1)
             );
 
-            end = false;
+            frames_inferred = 0;
+            frames_skipped = 0;
+            frames_dropped_moving = 0;
+            parts_done = 0;
+            first_part_start_ns = this->now().nanoseconds();
+            start_search();
         }
 
+        bool realtime_enabled() const { return realtime; }
+        const RealtimeConfig& get_realtime_config() const { return realtime_config; }
+
     private:
         rclcpp::Subscription<sensor_msgs::msg::Image>::SharedPtr camera_subscription_;
         rclcpp::Publisher<dynamixel_sdk_custom_interfaces::msg::SetPosition>::SharedPtr motor_publisher_;
+        rclcpp::Client<dynamixel_sdk_custom_interfaces::srv::GetPosition>::SharedPtr position_client_;
+        rclcpp::Publisher<dynamixel_sdk_custom_interfaces::msg::FrameTrace>::SharedPtr trace_publisher_;
+        rclcpp::Subscription<dynamixel_sdk_custom_interfaces::msg::MotorWriteAck>::SharedPtr motor_write_ack_subscription_;
+        std::unique_ptr<AsyncLogger> logger;
         XNn_inference ip_inst;
+        std::unique_ptr<InferenceScheduler> scheduler;
         int current_rotation_motor_angle;
         int current_angle_motor_angle;
         uint32_t nn_output;
-        bool end;
+        NodeState state;
+        FrameWorkspace workspace;
+        BoltAngleEstimator angle_estimator;
+        std::unique_ptr<RotationSearchStrategy> rotation_search;
+        uint32_t search_frames; // Frames processed since the start of the search
+
+        // Frame-difference gate
+        InferenceGate inference_gate;
+        uint64_t frames_inferred;
+        uint64_t frames_skipped;
+
+        // Commanded motor, with its position read back to know when it settled
+        struct TrackedMotor {
+            uint8_t id;
+            MotorSettleTracker settle;
+            bool request_pending;
+        };
+
+        // Motion-aware gating
+        bool motion_gating;
+        TrackedMotor rotation_motor;
+        TrackedMotor angle_motor;
+        uint64_t frames_dropped_moving;
+
+        // Multi-crop search
+        bool multi_crop;
+        int crop_count;
+        double crop_width_ratio;
+        double pixels_per_rotation_unit;
+        int crop_offset; // Rotation (motor units) towards the crops that found the bolt at the last inference
+
+        bool realtime;
+        RealtimeConfig realtime_config;
+
+        // Latency tracing
+        std::unique_ptr<LatencyTracer> tracer;
+        int64_t latency_slo_ns;
+        uint64_t slo_violations;
+
+        // Continuous mode
+        bool continuous_mode;
+        double part_change_threshold;
+        FrameChangeDetector part_detector;
+        uint64_t parts_done;
+        int64_t first_part_start_ns;
+        int64_t part_start_ns;
 
         // Main loop
         void onImageMsg(const sensor_msgs::msg::Image::SharedPtr msg) 
         {
-            if (end) { return; }
-            cv_bridge::CvImagePtr cv_ptr = cv_bridge::toCvCopy(msg, msg->encoding);
-            cv::Mat img = cv_ptr->image;
+            if (state == NodeState::DONE) { return; }
+            if (motion_gating && !frame_after_settle(msg->header.stamp)) {
+                frames_dropped_moving++;
+                return;
+            }
 
-            nn_output = get_nn_output(img);
-            std::cout << "NN output at rotation angle " << current_rotation_motor_angle << ": " << nn_output << std::endl;
+            tracer->begin_frame(rclcpp::Time(msg->header.stamp).nanoseconds());
+            switch (state) {
+                case NodeState::SEARCH:
+                    search_step(msg);
+                    break;
+                case NodeState::ORIENT:
+                    if (motor_settled(angle_motor)) { part_done(); }
+                    break;
+                case NodeState::RESET:
+                    if (motor_settled(rotation_motor) && motor_settled(angle_motor)) {
+                        // Reference view of the part that was just processed
+                        part_detector.reset();
+                        part_detector.distance(msg->data.data(), msg->width, msg->height, msg->step);
+                        part_detector.set_reference();
+                        state = NodeState::WAIT_PART;
+                        ASYNC_LOG_INFO(*logger, "Motors homed, waiting for the next part");
+                    }
+                    break;
+                case NodeState::WAIT_PART: {
+                    double diff = part_detector.distance(msg->data.data(), msg->width, msg->height, msg->step);
+                    if (diff >= part_change_threshold) {
+                        ASYNC_LOG_INFO(*logger, "Scene changed (diff %.2f), searching the next part", diff);
+                        start_search();
+                    }
+                    break;
+                }
+                case NodeState::DONE:
+                    break;
+            }
+            tracer->end_frame();
+        }
+
+        void start_search()
+        {
+            current_rotation_motor_angle = rotation_search->reset();
+            search_frames = 0;
+            inference_gate.reset();
+            part_start_ns = this->now().nanoseconds();
+            state = NodeState::SEARCH;
+        }
+
+        void search_step(const sensor_msgs::msg::Image::SharedPtr& msg)
+        {
+            // YUYV frames are used in place, the message outlives the callback
+            cv_bridge::CvImagePtr cv_ptr;
+            cv::Mat img;
+            if (msg->encoding == "yuv422_yuy2" || msg->encoding == "yuyv") {
+                img = cv::Mat(msg->height, msg->width, CV_8UC2, msg->data.data(), msg->step);
+            }
+            else {
+                TraceScope trace(*tracer, TraceStage::PREPROCESS);
+                cv_ptr = cv_bridge::toCvCopy(msg, msg->encoding);
+                img = cv_ptr->image;
+            }
+            if (workspace.reserve(img.size())) {
+                angle_estimator.reserve(img.size());
+            }
+
+            nn_output = gated_nn_output(img);
+            search_frames++;
+            ASYNC_LOG_INFO(*logger, "NN output at rotation angle %d: %u", current_rotation_motor_angle, nn_output);
             if (nn_output == NN_CORRECT_LABEL) {
-                std::cout << "Correct label found, now calculating the angle of the bolt" << std::endl;
+                ASYNC_LOG_INFO(*logger, "Correct label found after %u frames, now calculating the angle of the bolt", search_frames);
                 double bolt_rotation_angle = find_rotation_angle(img);
-                std::cout << "Rotation angle found (in degrees): " << bolt_rotation_angle << std::endl;
+                ASYNC_LOG_INFO(*logger, "Rotation angle found (in degrees): %f", bolt_rotation_angle);
                 int32_t motor_angle = (int32_t)(bolt_rotation_angle * DEGREES_TO_MOTOR_ANGLE);
-                std::cout << "Moving the angle motor to position " << motor_angle << "..." << std::endl;
+                ASYNC_LOG_INFO(*logger, "Moving the angle motor to position %d...", motor_angle);
                 set_motor_position(ANGLE_MOTOR_ID, motor_angle);
-                end = true;
-                std::cout << "END" << std::endl;
+                state = NodeState::ORIENT;
                 return;
             }
-            current_rotation_motor_angle += ROTATION_MOTOR_STEP;
-            if (current_rotation_motor_angle < ROTATION_MOTOR_MAX_POS) {
-                current_rotation_motor_angle = ROTATION_MOTOR_MAX_POS;
+            if (!frame_after_settle(msg->header.stamp)) {
+                // Only without motion gating: the rotation motor did not reach its position yet, the next move
+                // waits for a frame of the settled position (an unchanged one reuses the prediction)
+                return;
+            }
+            if (multi_crop && crop_offset != 0) {
+                // Bolt seen in a crop: one move towards it, the next frame checks it on the whole frame.
+                // Never to a position already visited by this search, so that a crop false positive (never
+                // confirmed on the whole frame) cannot keep the search around it.
+                int target = current_rotation_motor_angle + crop_offset;
+                target = std::max(target, std::min(ROTATION_MOTOR_INIT_POS, ROTATION_MOTOR_MAX_POS));
+                target = std::min(target, std::max(ROTATION_MOTOR_INIT_POS, ROTATION_MOTOR_MAX_POS));
+                if (target != current_rotation_motor_angle && rotation_search->seek(target)) {
+                    current_rotation_motor_angle = target;
+                    ASYNC_LOG_INFO(*logger, "Bolt seen in a crop, moving the rotation motor to position %d...", current_rotation_motor_angle);
+                    set_motor_position(ROTATION_MOTOR_ID, current_rotation_motor_angle);
+                    return;
+                }
+            }
+            int next_position;
+            if (!rotation_search->next(nn_output, next_position)) {
+                search_exhausted();
+                return;
+            }
+            current_rotation_motor_angle = next_position;
+            ASYNC_LOG_INFO(*logger, "The label does not match with the goal, moving the rotation motor to position %d...", current_rotation_motor_angle);
+            set_motor_position(ROTATION_MOTOR_ID, current_rotation_motor_angle);
+        }
+
+        // Bolt oriented: count the part, then home the motors for the next one in continuous mode
+        void part_done()
+        {
+            int64_t now_ns = this->now().nanoseconds();
+            parts_done++;
+            double cycle_s = (now_ns - part_start_ns) / 1e9;
+            double parts_per_minute = parts_done * 60e9 / (double)std::max<int64_t>(now_ns - first_part_start_ns, 1);
+            ASYNC_LOG_INFO(
+                *logger,
+                "Part %lu done in %.2f s (%u search frames), %.2f parts per minute",
+                (unsigned long)parts_done,
+                cycle_s,
+                search_frames,
+                parts_per_minute
+            );
+
+            if (!continuous_mode) {
+                state = NodeState::DONE;
+                ASYNC_LOG_INFO(*logger, "END");
+                return;
+            }
+
+            home_motors();
+        }
+
+        // Whole range searched without finding the bolt (no part, or the part was removed): gives up on this
+        // scene instead of staying in SEARCH, the next part is waited for in continuous mode
+        void search_exhausted()
+        {
+            if (!continuous_mode) {
+                state = NodeState::DONE;
+                ASYNC_LOG_WARN(*logger, "Bolt not found after %u search frames, END", search_frames);
+                return;
+            }
+            ASYNC_LOG_WARN(*logger, "Bolt not found after %u search frames, homing and waiting for the next part", search_frames);
+            home_motors();
+        }
+
+        void home_motors()
+        {
+            current_rotation_motor_angle = rotation_search->reset();
+            set_motor_position(ROTATION_MOTOR_ID, current_rotation_motor_angle);
+            set_motor_position(ANGLE_MOTOR_ID, ANGLE_MOTOR_INIT_POS);
+            state = NodeState::RESET;
+        }
+
+        // Whether the frame was captured after the rotation motor settled at its commanded position
+        bool frame_after_settle(const builtin_interfaces::msg::Time& stamp)
+        {
+            if (!motor_settled(rotation_motor)) { return false; }
+            return rotation_motor.settle.frame_usable(rclcpp::Time(stamp).nanoseconds());
+        }
+
+        // While the motor is not known to be settled, its position is read back (one request at a time)
+        bool motor_settled(TrackedMotor& motor)
+        {
+            motor.settle.check_timeout(this->now().nanoseconds());
+            if (motor.settle.settled()) { return true; }
+            request_position(motor);
+            return false;
+        }
+
+        void request_position(TrackedMotor& motor)
+        {
+            if (motor.request_pending || !position_client_->service_is_ready()) { return; }
+
+            auto request = std::make_shared<dynamixel_sdk_custom_interfaces::srv::GetPosition::Request>();
+            request->id = motor.id;
+            uint32_t command_id = motor.settle.current_command();
+            motor.request_pending = true;
+            position_client_->async_send_request(
+                request,
+                [this, &motor, command_id](rclcpp::Client<dynamixel_sdk_custom_interfaces::srv::GetPosition>::SharedFuture future) {
+                    motor.request_pending = false;
+                    int32_t position = future.get()->position;
+                    if (motor.settle.position_read(command_id, position, this->now().nanoseconds())) {
+                        ASYNC_LOG_DEBUG(*logger, "Motor %u settled at position %d", motor.id, position);
+                    }
+                }
+            );
+        }
+
+        // NN output of the frame, reusing the last prediction when the rotation motor is settled, was not
+        // commanded since the last inference and the scene did not change
+        uint32_t gated_nn_output(cv::Mat& camera_img)
+        {
+            if (inference_gate.reuse(camera_img.data, camera_img.cols, camera_img.rows, camera_img.step, rotation_motor.settle)) {
+                frames_skipped++;
+                ASYNC_LOG_DEBUG(*logger, "Unchanged frame (diff %.2f), reusing the last prediction", inference_gate.distance());
+                report_frame_stats();
+                return nn_output;
+            }
+
+            AllocationScope allocations;
+            if (multi_crop) {
+                get_multi_crop_output(camera_img);
+            }
+            else {
+                get_nn_output(camera_img);
+            }
+            check_allocations(allocations.end());
+            inference_gate.inferred(rotation_motor.settle);
+            frames_inferred++;
+            report_frame_stats();
+            return nn_output;
+        }
+
+        // Debug builds: once warmed up, the inference path only uses the workspace and must not touch the heap
+        void check_allocations(uint64_t allocations)
+        {
+            if (!ALLOC_COUNTER_ENABLED || frames_inferred < ALLOC_WARMUP_FRAMES) { return; }
+            if (allocations != 0) {
+                RCLCPP_ERROR(
+                    this->get_logger(),
+                    "%lu heap allocation(s) during inference %lu",
+                    (unsigned long)allocations,
+                    (unsigned long)frames_inferred
+                );
+            }
+            assert(allocations == 0);
+        }
+
+        void report_frame_stats()
+        {
+            if ((frames_inferred + frames_skipped) % FRAME_STATS_PERIOD == 0) {
+                ASYNC_LOG_INFO(
+                    *logger,
+                    "Frames: %lu inferred, %lu skipped as unchanged, %lu dropped while the motor moved",
+                    (unsigned long)frames_inferred,
+                    (unsigned long)frames_skipped,
+                    (unsigned long)frames_dropped_moving
+                );
+                for (size_t i = 0; i < scheduler->backend_count(); i++) {
+                    InferenceScheduler::BackendStats stats = scheduler->backend_stats(i);
+                    ASYNC_LOG_INFO(
+                        *logger,
+                        "Inference backend %s: %lu inferences, %.1f us mean, %.1f%% busy",
+                        stats.name,
+                        (unsigned long)stats.inferences,
+                        stats.mean_service_us,
+                        stats.utilization * 100
+                    );
+                }
             }
-            std::cout << "The label does not match with the goal, moving the rotation motor to position " << current_rotation_motor_angle << "..." << std::endl;
-            set_motor_position(ROTATION_MOTOR_ID, current_rotation_motor_angle + ROTATION_MOTOR_STEP);
         }
 
         void set_motor_position(uint8_t motor_id, int32_t angle)
@@ -99,104 +569,156 @@ class ImageSubscriber : public rclcpp::Node
             new_pos.id = motor_id;
             new_pos.position = angle;
 
-            motor_publisher_->publish(new_pos);
+            {
+                TraceScope trace(*tracer, TraceStage::PUBLISH);
+                new_pos.trace_id = tracer->command_published();
+                motor_publisher_->publish(new_pos);
+            }
+
+            if (motor_id == ROTATION_MOTOR_ID) {
+                rotation_motor.settle.command(angle, this->now().nanoseconds());
+            }
+            else if (motor_id == ANGLE_MOTOR_ID) {
+                angle_motor.settle.command(angle, this->now().nanoseconds());
+            }
         }
 
         // One neural network inference and return the output
         uint32_t get_nn_output(cv::Mat& camera_img)
         {
-            cv::Mat img_rgb;
-            cv::cvtColor(camera_img, img_rgb, cv::COLOR_YUV2RGB_YUY2);
-            cv::Mat resized_img;
-            cv::resize(camera_img, resized_img, cv::Size(RESIZED_IMG_WIDTH, RESIZED_IMG_HEIGHT));
+            to_rgb(camera_img);
+            preprocess(workspace.img_rgb, workspace.nn_input(0));
+            return nn_output = wait_inference(start_inference(workspace.nn_input(0)));
+        }
 
-            // Flatten and normalize
-            std::vector<float> nn_input_img;
-            for (int row = 0; row < resized_img.rows; row++) {
-                for (int col = 0; col < resized_img.cols; col++) {
-                    for (int color = 0; color < 3; color++) {
-                        nn_input_img.push_back((float)img_rgb.at<cv::Vec3b>(row,col)[color] / (float)255);
-                    }
-                }
+        // Whole frame inference (returned), followed by one inference per crop to set crop_offset.
+        // Every input is submitted as soon as it is preprocessed, so the backends run while the next ones are
+        // prepared.
+        uint32_t get_multi_crop_output(cv::Mat& camera_img)
+        {
+            to_rgb(camera_img);
+            const cv::Mat& img_rgb = workspace.img_rgb;
+
+            const int crop_width = std::max(1, (int)(img_rgb.cols * crop_width_ratio));
+            auto crop_rect = [&](int crop) {
+                int x = (crop_count > 1) ? crop * (img_rgb.cols - crop_width) / (crop_count - 1) : (img_rgb.cols - crop_width) / 2;
+                return cv::Rect(x, 0, crop_width, img_rgb.rows);
+            };
+
+            // Input 0 is the whole frame, input i >= 1 is crop i - 1
+            const int num_inputs = crop_count + 1;
+            int tickets[NN_INPUT_BUFFERS];
+            for (int i = 0; i < num_inputs; i++) {
+                preprocess((i == 0) ? img_rgb : img_rgb(crop_rect(i - 1)), workspace.nn_input(i));
+                tickets[i] = start_inference(workspace.nn_input(i));
             }
 
-            XNn_inference_Write_input_img_Words(&ip_inst, 0, (unsigned int *)nn_input_img.data(), RESIZED_IMG_WIDTH * RESIZED_IMG_HEIGHT * 3);
-            XNn_inference_Start(&ip_inst);
-
-            // Wait for the IP core to finish
-            while (!XNn_inference_IsDone(&ip_inst));
+            int fired = 0;
+            double fired_center_sum = 0;
+            for (int i = 0; i < num_inputs; i++) {
+                uint32_t output = wait_inference(tickets[i]);
+                if (i == 0) {
+                    nn_output = output;
+                }
+                else if (output == NN_CORRECT_LABEL) {
+                    cv::Rect crop = crop_rect(i - 1);
+                    fired_center_sum += crop.x + crop.width / 2.0;
+                    fired++;
+                }
+            }
 
-            return nn_output = XNn_inference_Get_return(&ip_inst);
+            crop_offset = 0;
+            if (fired > 0) {
+                double offset_px = fired_center_sum / fired - img_rgb.cols / 2.0;
+                crop_offset = (int)std::lround(offset_px / pixels_per_rotation_unit);
+                ASYNC_LOG_DEBUG(*logger, "Bolt in %d crop(s), %.1f px from the center", fired, offset_px);
+            }
+            return nn_output;
         }
 
-        // Canny filter impelmentation to get the angle of a bole / screw
-        double find_rotation_angle(const cv::Mat& camera_img)
+        void to_rgb(const cv::Mat& camera_img)
         {
-            cv::Mat img_grayscale;
-            cv::cvtColor(camera_img, img_grayscale, cv::COLOR_YUV2GRAY_YUY2);
-
-            cv::Mat thresh;
-            cv::threshold(img_grayscale, thresh, 94, 500, cv::THRESH_BINARY_INV);
+            TraceScope trace(*tracer, TraceStage::PREPROCESS);
+            yuyv_to_rgb(camera_img, workspace.img_rgb);
+        }
 
-            std::vector<std::vector<cv::Point>> contours;
-            cv::findContours(thresh, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        // Resizes an RGB image (or ROI) to the NN input size, then flattens and normalizes it
+        void preprocess(const cv::Mat& rgb, float* nn_input)
+        {
+            TraceScope trace(*tracer, TraceStage::PREPROCESS);
+            cv::Mat& resized_img = workspace.resized_img;
+            cv::resize(rgb, resized_img, cv::Size(RESIZED_IMG_WIDTH, RESIZED_IMG_HEIGHT));
 
-            if (contours.empty()) { return 0.0; }
+            int i = 0;
+            for (int row = 0; row < resized_img.rows; row++) {
+                for (int col = 0; col < resized_img.cols; col++) {
+                    for (int color = 0; color < 3; color++) {
+                        nn_input[i++] = (float)resized_img.at<cv::Vec3b>(row,col)[color] / (float)255;
+                    }
+                }
+            }
+        }
 
-            std::sort(contours.begin(), contours.end(), [](const auto& a, const auto& b) {
-                return cv::contourArea(a) > cv::contourArea(b);
-            });
+        // Queues an inference of nn_input, which must stay untouched until wait_inference()
+        int start_inference(const float* nn_input)
+        {
+            TraceScope trace(*tracer, TraceStage::INFERENCE);
+            return scheduler->submit(nn_input);
+        }
 
-            int num_lines = 0;
-            uint32_t num = 0;
-            auto& selected_contour = contours[num];
+        uint32_t wait_inference(int ticket)
+        {
+            TraceScope trace(*tracer, TraceStage::INFERENCE);
+            return scheduler->wait(ticket);
+        }
 
-            while (num_lines < 2 || num_lines > 6) {
-                if (num < contours.size()) {
-                    selected_contour = contours[num];
-                }
-                else {
-                    return 0.0;
+        // Completed latency trace: published on the metrics topic and checked against the SLO
+        void on_frame_trace(const FrameTraceRecord& record)
+        {
+            auto latency_us = [&record](int64_t ns) { return (ns != 0) ? (ns - record.capture_ns) / 1e3f : -1.0f; };
+
+            dynamixel_sdk_custom_interfaces::msg::FrameTrace trace_msg;
+            trace_msg.trace_id = record.trace_id;
+            trace_msg.stamp = rclcpp::Time(record.capture_ns);
+            trace_msg.receive_latency_us = latency_us(record.receive_ns);
+            trace_msg.preprocess_us = record.stage_ns[(int)TraceStage::PREPROCESS] / 1e3f;
+            trace_msg.inference_us = record.stage_ns[(int)TraceStage::INFERENCE] / 1e3f;
+            trace_msg.angle_us = record.stage_ns[(int)TraceStage::ANGLE] / 1e3f;
+            trace_msg.publish_us = record.stage_ns[(int)TraceStage::PUBLISH] / 1e3f;
+            trace_msg.callback_latency_us = latency_us(record.end_ns);
+            trace_msg.publish_latency_us = latency_us(record.publish_ns);
+            trace_msg.motor_write_latency_us = latency_us(record.motor_write_ns);
+            trace_msg.commands = record.commands;
+            trace_msg.acks = record.acks;
+            trace_publisher_->publish(trace_msg);
+
+            if (latency_slo_ns > 0 && record.commands > 0) {
+                // A command never acknowledged counts as a violation
+                bool acknowledged = (record.acks == record.commands);
+                if (!acknowledged || record.motor_write_ns - record.capture_ns > latency_slo_ns) {
+                    slo_violations++;
+                    ASYNC_LOG_WARN(
+                        *logger,
+                        "Frame %u over the latency SLO: %s %.2f ms after capture (%lu violations)",
+                        record.trace_id,
+                        acknowledged ? "motor written" : "motor write not acknowledged, published",
+                        (acknowledged ? trace_msg.motor_write_latency_us : trace_msg.publish_latency_us) / 1e3,
+                        (unsigned long)slo_violations
+                    );
                 }
-                cv::Mat bolt_contour_img = cv::Mat::zeros(img_grayscale.size(), img_grayscale.type());
-                cv::drawContours(
-                    bolt_contour_img,
-                    std::vector<std::vector<cv::Point>>{selected_contour},
-                    -1,
-                    255,
-                    cv::FILLED
-                );
+            }
+        }
 
-                cv::Mat edges;
-                cv::Canny(bolt_contour_img, edges, 50, 100);
-
-                std::vector<cv::Vec2f> lines;
-                cv::HoughLines(edges, lines, 1, CV_PI / 60, 30);
-
-                if (!lines.empty()) {
-                    num_lines = static_cast<int>(lines.size());
-                    double theta = 0;
-                    if (num_lines >= 2 && num_lines <= 6) {
-                        for (const auto& line : lines) {
-                            theta = line[0];
-                            if (
-                                (cv::fastAtan2(static_cast<float>(std::sin(theta)), static_cast<float>(std::cos(theta))) >= 0) &&
-                                (cv::fastAtan2(static_cast<float>(std::sin(theta)), static_cast<float>(std::cos(theta))) < 180)
-                            ) {                               
-                                if (cv::fastAtan2(static_cast<float>(std::sin(theta)), static_cast<float>(std::cos(theta))) <= 60) {
-                                    return cv::fastAtan2(static_cast<float>(std::sin(theta)), static_cast<float>(std::cos(theta)));
-                                }
-                            }
-                        }
-                        if (cv::fastAtan2(static_cast<float>(std::sin(theta)), static_cast<float>(std::cos(theta))) > 60) {
-                            float current_angle = cv::fastAtan2(static_cast<float>(std::sin(theta)), static_cast<float>(std::cos(theta)));
-                            return ((uint32_t)(std::abs(static_cast<float>(current_angle)))) % 60;
-                        }
-                    } 
-                    num++;
-                }
-            } 
-            return 0.0;
+        // Rotation angle of the bolt / screw in the camera frame
+        double find_rotation_angle(const cv::Mat& camera_img)
+        {
+            TraceScope trace(*tracer, TraceStage::ANGLE);
+            AllocationScope allocations;
+            cv::cvtColor(camera_img, workspace.img_grayscale, cv::COLOR_YUV2GRAY_YUY2);
+            double angle = angle_estimator.find_rotation_angle(workspace.img_grayscale);
+            // Not asserted: cv::findContours allocates its own storage on every call
+            ASYNC_LOG_DEBUG(*logger, "Angle estimation: %lu heap allocation(s)", (unsigned long)allocations.end());
+            return angle;
         }
 };
 
@@ -204,10 +726,36 @@ class ImageSubscriber : public rclcpp::Node
 
 int main(int argc, char *argv[])
 {
-    setvbuf(stdout,NULL,_IONBF,BUFSIZ);
-
     rclcpp::init(argc,argv);
-    rclcpp::spin(std::make_shared<ImageSubscriber>());
+    auto node = std::make_shared<ImageSubscriber>();
+
+    if (!node->realtime_enabled()) {
+        rclcpp::spin(node);
+        rclcpp::shutdown();
+        return 0;
+    }
+
+    // Real-time mode: locked memory, and the executor on a dedicated pinned SCHED_FIFO thread. The inference
+    // workers were given the same settings by the node, the ones created by the executor thread (parallel angle
+    // estimation) inherit them. Only the logger drain thread keeps the default policy, nothing waits for it.
+    const RealtimeConfig& config = node->get_realtime_config();
+    std::string error;
+    if (!lock_process_memory(config.prefault_heap_bytes, error)) {
+        RCLCPP_WARN(node->get_logger(), "Could not lock the memory: %s", error.c_str());
+    }
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(node);
+    std::thread executor_thread([&]() {
+        std::string thread_error;
+        if (!configure_realtime_thread(config, thread_error)) {
+            RCLCPP_WARN(node->get_logger(), "Could not configure the real-time thread: %s", thread_error.c_str());
+        }
+        else {
+            RCLCPP_INFO(node->get_logger(), "Real-time executor: SCHED_FIFO priority %d on %zu core(s)", config.priority, config.cpus.size());
+        }
+        executor.spin();
+    });
+    executor_thread.join();
 
     rclcpp::shutdown();
     return 0;
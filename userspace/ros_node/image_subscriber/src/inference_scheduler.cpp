@@ -0,0 +1,184 @@
+#include "inference_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "nn_cpu_engine.hpp"
+
+InferenceScheduler::InferenceScheduler(XNn_inference* ip, int cpu_workers, const RealtimeConfig* realtime)
+: ip(ip),
+  stopping(false),
+  start_ns(now_ns()),
+  workers_started(0)
+{
+    for (int i = 0; i < INFERENCE_MAX_JOBS; i++) {
+        jobs[i] = {nullptr, 0, false, false};
+    }
+    service_ns[(int)BackendKind::FPGA] = INFERENCE_FPGA_PRIOR_US * 1000.0;
+    service_ns[(int)BackendKind::CPU] = INFERENCE_CPU_PRIOR_US * 1000.0;
+
+    auto add_backend = [this](BackendKind kind, const char* name) {
+        std::unique_ptr<Backend> backend(new Backend());
+        backend->kind = kind;
+        snprintf(backend->name, sizeof(backend->name), "%s", name);
+        backend->queue_head = 0;
+        backend->queue_count = 0;
+        backend->available_at_ns = 0;
+        backend->busy_ns = 0;
+        backend->inferences = 0;
+        backends.push_back(std::move(backend));
+    };
+
+    if (ip != nullptr) {
+        add_backend(BackendKind::FPGA, "fpga");
+    }
+    for (int i = 0; i < cpu_workers; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "cpu%d", i);
+        add_backend(BackendKind::CPU, name);
+    }
+
+    // Started once the backend list is complete, the workers never see it change
+    for (auto& backend : backends) {
+        Backend* b = backend.get();
+        b->thread = std::thread([this, b, realtime]() { worker_loop(*b, realtime); });
+    }
+
+    // The real-time settings are applied by the workers themselves, done before the first submit()
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this]() { return workers_started == backends.size(); });
+}
+
+InferenceScheduler::~InferenceScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    for (auto& backend : backends) {
+        backend->work_cv.notify_one();
+        backend->thread.join();
+    }
+}
+
+int64_t InferenceScheduler::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+int InferenceScheduler::submit(const float* nn_input)
+{
+    if (backends.empty()) { return -1; }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    int ticket = -1;
+    for (int i = 0; i < INFERENCE_MAX_JOBS; i++) {
+        if (!jobs[i].pending) {
+            ticket = i;
+            break;
+        }
+    }
+    if (ticket < 0) { return -1; }
+
+    // Earliest estimated completion time
+    int64_t now = now_ns();
+    Backend* best = nullptr;
+    int64_t best_completion_ns = 0;
+    for (auto& backend : backends) {
+        int64_t completion_ns = std::max(now, backend->available_at_ns) + (int64_t)service_ns[(int)backend->kind];
+        if (best == nullptr || completion_ns < best_completion_ns) {
+            best = backend.get();
+            best_completion_ns = completion_ns;
+        }
+    }
+
+    jobs[ticket] = {nn_input, 0, true, false};
+    best->queue[(best->queue_head + best->queue_count) % INFERENCE_MAX_JOBS] = ticket;
+    best->queue_count++;
+    best->available_at_ns = best_completion_ns;
+    lock.unlock();
+
+    best->work_cv.notify_one();
+    return ticket;
+}
+
+uint32_t InferenceScheduler::wait(int ticket)
+{
+    if (ticket < 0 || ticket >= INFERENCE_MAX_JOBS) { return UINT32_MAX; }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this, ticket]() { return jobs[ticket].done; });
+    jobs[ticket].pending = false;
+    return jobs[ticket].output;
+}
+
+InferenceScheduler::BackendStats InferenceScheduler::backend_stats(size_t index)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const Backend& backend = *backends[index];
+    double elapsed_ns = (double)std::max<int64_t>(now_ns() - start_ns, 1);
+    return {
+        backend.name,
+        backend.inferences,
+        (backend.inferences > 0) ? backend.busy_ns / 1000.0 / backend.inferences : 0.0,
+        backend.busy_ns / elapsed_ns
+    };
+}
+
+void InferenceScheduler::worker_loop(Backend& backend, const RealtimeConfig* realtime)
+{
+    std::string error;
+    bool configured = (realtime == nullptr) || configure_realtime_thread(*realtime, error);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!configured && worker_error.empty()) {
+        worker_error = std::string(backend.name) + ": " + error;
+    }
+    workers_started++;
+    done_cv.notify_all();
+
+    for (;;) {
+        backend.work_cv.wait(lock, [this, &backend]() { return stopping || backend.queue_count > 0; });
+        if (backend.queue_count == 0) { return; } // Stopping
+
+        int ticket = backend.queue[backend.queue_head];
+        backend.queue_head = (backend.queue_head + 1) % INFERENCE_MAX_JOBS;
+        backend.queue_count--;
+        const float* input = jobs[ticket].input;
+        lock.unlock();
+
+        int64_t begin_ns = now_ns();
+        uint32_t output = run(backend, input);
+        int64_t end_ns = now_ns();
+
+        lock.lock();
+        jobs[ticket].output = output;
+        jobs[ticket].done = true;
+        backend.inferences++;
+        backend.busy_ns += end_ns - begin_ns;
+        double& estimate_ns = service_ns[(int)backend.kind];
+        estimate_ns += INFERENCE_SERVICE_TIME_ALPHA * ((end_ns - begin_ns) - estimate_ns);
+        // Estimates only ever delay the backend, an idle one is available right away
+        if (backend.queue_count == 0) { backend.available_at_ns = end_ns; }
+        done_cv.notify_all();
+    }
+}
+
+uint32_t InferenceScheduler::run(Backend& backend, const float* nn_input)
+{
+    if (backend.kind == BackendKind::CPU) {
+        return nn_cpu_inference(nn_input);
+    }
+
+    XNn_inference_Write_input_img_Words(ip, 0, (word_type *)nn_input, NN_INPUTS);
+    XNn_inference_Start(ip);
+
+    // Wait for the IP core to finish
+    while (!XNn_inference_IsDone(ip));
+
+    return XNn_inference_Get_return(ip);
+}
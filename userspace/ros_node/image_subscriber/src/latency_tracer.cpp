@@ -0,0 +1,254 @@
+#include "latency_tracer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// Chrome trace thread ids
+#define CHROME_TID_TRANSPORT 1 // Camera stamp to image callback
+#define CHROME_TID_NODE 2      // Image callback and its stages
+#define CHROME_TID_MOTOR 3     // SetPosition publish to servo write
+
+const char* trace_stage_name(TraceStage stage)
+{
+    switch (stage) {
+        case TraceStage::PREPROCESS: return "preprocess";
+        case TraceStage::INFERENCE: return "inference";
+        case TraceStage::ANGLE: return "angle";
+        case TraceStage::PUBLISH: return "publish";
+    }
+    return "unknown";
+}
+
+static double to_us(int64_t ns)
+{
+    return ns / 1000.0;
+}
+
+// Latency from the capture in microseconds, -1 when the step did not happen
+static double latency_us(int64_t capture_ns, int64_t ns)
+{
+    return (ns != 0) ? to_us(ns - capture_ns) : -1.0;
+}
+
+LatencyTracer::LatencyTracer(const std::string& csv_path, const std::string& chrome_trace_path)
+: enabled(true),
+  in_frame(false),
+  next_trace_id(1),
+  csv_file(nullptr),
+  chrome_file(nullptr),
+  chrome_first_event(true),
+  chrome_origin_ns(0)
+{
+    memset(&current, 0, sizeof(current));
+
+    // Buffered, the records are written by the image callback
+    if (!csv_path.empty()) {
+        csv_file = fopen(csv_path.c_str(), "w");
+        if (csv_file != nullptr) {
+            setvbuf(csv_file, nullptr, _IOFBF, TRACE_FILE_BUFFER_SIZE);
+            fprintf(csv_file, "trace_id,capture_ns,receive_latency_us");
+            for (int stage = 0; stage < TRACE_STAGE_COUNT; stage++) {
+                fprintf(csv_file, ",%s_us", trace_stage_name((TraceStage)stage));
+            }
+            fprintf(csv_file, ",callback_latency_us,publish_latency_us,motor_write_latency_us,commands,acks\n");
+        }
+    }
+    if (!chrome_trace_path.empty()) {
+        chrome_file = fopen(chrome_trace_path.c_str(), "w");
+        if (chrome_file != nullptr) {
+            setvbuf(chrome_file, nullptr, _IOFBF, TRACE_FILE_BUFFER_SIZE);
+            fprintf(chrome_file, "[\n");
+        }
+    }
+}
+
+LatencyTracer::~LatencyTracer()
+{
+    // Frames still waiting for an acknowledgement only go to the files, the owner may be half destroyed
+    on_complete = nullptr;
+    while (!pending.empty()) {
+        complete(pending.front());
+        pending.pop_front();
+    }
+    if (csv_file != nullptr) {
+        fclose(csv_file);
+    }
+    if (chrome_file != nullptr) {
+        fprintf(chrome_file, "\n]\n");
+        fclose(chrome_file);
+    }
+}
+
+int64_t LatencyTracer::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+void LatencyTracer::begin_frame(int64_t capture_ns)
+{
+    if (!enabled) { return; }
+
+    memset(&current, 0, sizeof(current));
+    current.trace_id = next_trace_id++;
+    if (next_trace_id == 0) { next_trace_id = 1; } // 0 means not traced
+    current.capture_ns = capture_ns;
+    current.receive_ns = now_ns();
+    in_frame = true;
+}
+
+void LatencyTracer::stage_begin(TraceStage stage)
+{
+    if (!in_frame) { return; }
+
+    int64_t now = now_ns();
+    current_stage_start_ns[(int)stage] = now;
+    if (current.stage_start_ns[(int)stage] == 0) {
+        current.stage_start_ns[(int)stage] = now;
+    }
+}
+
+void LatencyTracer::stage_end(TraceStage stage)
+{
+    if (!in_frame) { return; }
+
+    current.stage_ns[(int)stage] += now_ns() - current_stage_start_ns[(int)stage];
+}
+
+uint32_t LatencyTracer::command_published()
+{
+    if (!in_frame) { return 0; }
+
+    current.publish_ns = now_ns();
+    current.commands++;
+    return current.trace_id;
+}
+
+void LatencyTracer::end_frame()
+{
+    if (!in_frame) { return; }
+
+    in_frame = false;
+    current.end_ns = now_ns();
+    if (current.commands == 0) {
+        complete(current);
+    }
+    else {
+        if (pending.size() >= TRACE_MAX_PENDING) {
+            complete(pending.front());
+            pending.pop_front();
+        }
+        pending.push_back(current);
+    }
+    expire_pending(current.end_ns);
+}
+
+void LatencyTracer::motor_written(uint32_t trace_id, int64_t write_ns)
+{
+    if (trace_id == 0) { return; }
+
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+        if (it->trace_id != trace_id) { continue; }
+
+        it->acks++;
+        it->motor_write_ns = std::max(it->motor_write_ns, write_ns);
+        if (it->acks >= it->commands) {
+            complete(*it);
+            pending.erase(it);
+        }
+        return;
+    }
+}
+
+void LatencyTracer::expire_pending(int64_t now_ns)
+{
+    while (!pending.empty() && now_ns - pending.front().end_ns > TRACE_ACK_TIMEOUT_NS) {
+        complete(pending.front());
+        pending.pop_front();
+    }
+}
+
+void LatencyTracer::complete(const FrameTraceRecord& record)
+{
+    if (csv_file != nullptr) {
+        write_csv(record);
+    }
+    if (chrome_file != nullptr) {
+        write_chrome_trace(record);
+    }
+    if (on_complete) {
+        on_complete(record);
+    }
+}
+
+void LatencyTracer::write_csv(const FrameTraceRecord& record)
+{
+    fprintf(
+        csv_file,
+        "%u,%lld,%.1f",
+        record.trace_id,
+        (long long)record.capture_ns,
+        latency_us(record.capture_ns, record.receive_ns)
+    );
+    for (int stage = 0; stage < TRACE_STAGE_COUNT; stage++) {
+        fprintf(csv_file, ",%.1f", to_us(record.stage_ns[stage]));
+    }
+    fprintf(
+        csv_file,
+        ",%.1f,%.1f,%.1f,%u,%u\n",
+        latency_us(record.capture_ns, record.end_ns),
+        latency_us(record.capture_ns, record.publish_ns),
+        latency_us(record.capture_ns, record.motor_write_ns),
+        record.commands,
+        record.acks
+    );
+}
+
+// Chrome trace event format (chrome://tracing, Perfetto), complete events in microseconds
+void LatencyTracer::write_chrome_trace(const FrameTraceRecord& record)
+{
+    if (chrome_first_event) {
+        chrome_origin_ns = record.capture_ns;
+        fprintf(
+            chrome_file,
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"camera to node\"}},\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"image_subscriber\"}},\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"motor write\"}}",
+            CHROME_TID_TRANSPORT,
+            CHROME_TID_NODE,
+            CHROME_TID_MOTOR
+        );
+        chrome_first_event = false;
+    }
+
+    chrome_event("receive", CHROME_TID_TRANSPORT, record.capture_ns, record.receive_ns - record.capture_ns, record.trace_id);
+    chrome_event("frame", CHROME_TID_NODE, record.receive_ns, record.end_ns - record.receive_ns, record.trace_id);
+    for (int stage = 0; stage < TRACE_STAGE_COUNT; stage++) {
+        if (record.stage_start_ns[stage] == 0) { continue; }
+        chrome_event(
+            trace_stage_name((TraceStage)stage),
+            CHROME_TID_NODE,
+            record.stage_start_ns[stage],
+            record.stage_ns[stage],
+            record.trace_id
+        );
+    }
+    if (record.motor_write_ns != 0) {
+        chrome_event("motor_write", CHROME_TID_MOTOR, record.publish_ns, record.motor_write_ns - record.publish_ns, record.trace_id);
+    }
+}
+
+void LatencyTracer::chrome_event(const char* name, int tid, int64_t start_ns, int64_t duration_ns, uint32_t trace_id)
+{
+    fprintf(
+        chrome_file,
+        ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"trace_id\":%u}}",
+        name,
+        tid,
+        to_us(start_ns - chrome_origin_ns),
+        to_us(duration_ns),
+        trace_id
+    );
+}
@@ -0,0 +1,54 @@
+#include "nn_cpu_engine.hpp"
+
+// The weight files are C initializers exported by AI_training/ai_training.py (include path set in CMakeLists.txt)
+static const float layer1_weights[NN_INPUTS][NN_LAYER1] =
+#include "layer_1_weights.txt"
+;
+static const float layer2_weights[NN_LAYER1][NN_LAYER2] =
+#include "layer_2_weights.txt"
+;
+static const float layer3_weights[NN_LAYER2][NN_LAYER3] =
+#include "layer_3_weights.txt"
+;
+
+// output = ReLU(input x weights). The loops run over the outputs innermost so that the weight rows are read
+// sequentially (and vectorized), each output still accumulating its products in input order like the IP.
+template <int N_IN, int N_OUT>
+static void dense_relu(const float* input, const float (&weights)[N_IN][N_OUT], float (&output)[N_OUT])
+{
+    for (int j = 0; j < N_OUT; j++) {
+        output[j] = 0;
+    }
+    for (int k = 0; k < N_IN; k++) {
+        const float in = input[k];
+        for (int j = 0; j < N_OUT; j++) {
+            output[j] += in * weights[k][j];
+        }
+    }
+    for (int j = 0; j < N_OUT; j++) {
+        if (output[j] < 0.0f) { output[j] = 0.0f; }
+    }
+}
+
+uint32_t nn_cpu_inference(const float* input_img)
+{
+    float layer1[NN_LAYER1];
+    float layer2[NN_LAYER2];
+    dense_relu(input_img, layer1_weights, layer1);
+    dense_relu(layer1, layer2_weights, layer2);
+
+    // Softmax is monotonic: the prediction is the argmax of the last layer
+    int max_idx = -1;
+    float max_val = -999.9f;
+    for (int j = 0; j < NN_LAYER3; j++) {
+        float sum = 0;
+        for (int k = 0; k < NN_LAYER2; k++) {
+            sum += layer2[k] * layer3_weights[k][j];
+        }
+        if (sum > max_val) {
+            max_idx = j;
+            max_val = sum;
+        }
+    }
+    return static_cast<uint32_t>(max_idx);
+}
@@ -0,0 +1,92 @@
+#include "realtime.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <alloca.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static std::string errno_message(const char* call)
+{
+    return std::string(call) + ": " + strerror(errno);
+}
+
+bool lock_process_memory(size_t prefault_heap_bytes, std::string& error)
+{
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        error = errno_message("mlockall");
+        return false;
+    }
+
+    // Freed memory stays in the heap instead of going back to the system, large blocks come from the heap
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    if (prefault_heap_bytes > 0) {
+        char* heap = (char*)malloc(prefault_heap_bytes);
+        if (heap == nullptr) {
+            error = "Could not prefault the heap";
+            return false;
+        }
+        long page_size = sysconf(_SC_PAGESIZE);
+        for (size_t i = 0; i < prefault_heap_bytes; i += page_size) {
+            heap[i] = 0;
+        }
+        free(heap);
+    }
+    return true;
+}
+
+bool pin_current_thread(const std::vector<int>& cpus, std::string& error)
+{
+    if (cpus.empty()) { return true; }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    int status = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (status != 0) {
+        error = std::string("pthread_setaffinity_np: ") + strerror(status);
+        return false;
+    }
+    return true;
+}
+
+bool set_current_thread_fifo(int priority, std::string& error)
+{
+    if (priority <= 0) { return true; }
+
+    sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int status = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (status != 0) {
+        error = std::string("pthread_setschedparam: ") + strerror(status) + " (needs CAP_SYS_NICE or an rtprio limit)";
+        return false;
+    }
+    return true;
+}
+
+void prefault_stack(size_t bytes)
+{
+    volatile char* stack = (volatile char*)alloca(bytes);
+    long page_size = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < bytes; i += page_size) {
+        stack[i] = 0;
+    }
+}
+
+bool configure_realtime_thread(const RealtimeConfig& config, std::string& error)
+{
+    if (!pin_current_thread(config.cpus, error)) { return false; }
+    if (!set_current_thread_fifo(config.priority, error)) { return false; }
+    prefault_stack(RT_STACK_PREFAULT_BYTES);
+    return true;
+}
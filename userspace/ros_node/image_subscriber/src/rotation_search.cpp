@@ -0,0 +1,175 @@
+#include "rotation_search.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+LinearSearch::LinearSearch(int start, int end, int step)
+: start(start), end(end), step(std::abs(step) * (end >= start ? 1 : -1)), current(start)
+{
+    if (this->step == 0) { this->step = (end >= start) ? 1 : -1; }
+    reset();
+}
+
+int LinearSearch::reset()
+{
+    visited.assign(std::abs(end - start) + 1, false);
+    visited[0] = true;
+    current = start;
+    return current;
+}
+
+bool LinearSearch::next(uint32_t, int& position)
+{
+    // Positions visited before a seek() back to the scan are skipped
+    int candidate = current;
+    while (candidate != end) {
+        candidate += step;
+        if ((step > 0 && candidate > end) || (step < 0 && candidate < end)) {
+            candidate = end;
+        }
+        if (!visited[std::abs(candidate - start)]) {
+            visited[std::abs(candidate - start)] = true;
+            current = candidate;
+            position = current;
+            return true;
+        }
+    }
+    position = current;
+    return false;
+}
+
+bool LinearSearch::seek(int position)
+{
+    int low = std::min(start, end);
+    int high = std::max(start, end);
+    position = std::max(low, std::min(position, high));
+    if (visited[std::abs(position - start)]) { return false; }
+
+    visited[std::abs(position - start)] = true;
+    current = position;
+    return true;
+}
+
+CoarseToFineSearch::CoarseToFineSearch(int start, int end, const std::vector<int>& step_plan)
+: start(start), end(end), direction(end >= start ? 1 : -1), step_plan(step_plan)
+{
+    for (auto& step : this->step_plan) {
+        step = std::max(std::abs(step), 1);
+    }
+    if (this->step_plan.empty()) { this->step_plan.push_back(1); }
+    reset();
+}
+
+int CoarseToFineSearch::reset()
+{
+    visited.assign(std::abs(end - start) + 1, false);
+    pass = 0;
+    sweep.clear();
+    refinement.clear();
+    has_previous_sweep = false;
+    fill_sweep();
+
+    // The first sweep always starts at start
+    current = sweep.front();
+    sweep.pop_front();
+    current_is_sweep = true;
+    visited[0] = true;
+    return current;
+}
+
+// Positions of the current pass not visited by the previous ones, in the direction of the search
+void CoarseToFineSearch::fill_sweep()
+{
+    int step = step_plan[pass];
+    int length = std::abs(end - start);
+    for (int offset = 0; offset <= length; offset += step) {
+        int position = start + direction * offset;
+        if (!is_visited(position)) { sweep.push_back(position); }
+    }
+    // Always look at the end of the range once
+    if (pass + 1 == step_plan.size() && !is_visited(end) && (sweep.empty() || sweep.back() != end)) {
+        sweep.push_back(end);
+    }
+    has_previous_sweep = false;
+}
+
+bool CoarseToFineSearch::pop_next(int& position)
+{
+    while (!refinement.empty()) {
+        position = refinement.front();
+        refinement.pop_front();
+        if (!is_visited(position)) {
+            current_is_sweep = false;
+            return true;
+        }
+    }
+    for (;;) {
+        while (!sweep.empty()) {
+            position = sweep.front();
+            sweep.pop_front();
+            if (!is_visited(position)) {
+                current_is_sweep = true;
+                return true;
+            }
+        }
+        if (pass + 1 >= step_plan.size()) { return false; }
+        pass++;
+        fill_sweep();
+    }
+}
+
+bool CoarseToFineSearch::next(uint32_t nn_output, int& position)
+{
+    if (current_is_sweep) {
+        // Output change between two sweep positions: scan the interval in between, from the current position back
+        if (has_previous_sweep && nn_output != previous_sweep_output) {
+            int fine_step = step_plan.back();
+            for (int p = current - direction * fine_step; (p - previous_sweep_position) * direction > 0; p -= direction * fine_step) {
+                refinement.push_back(p);
+            }
+        }
+        has_previous_sweep = true;
+        previous_sweep_position = current;
+        previous_sweep_output = nn_output;
+    }
+
+    if (!pop_next(position)) {
+        position = current;
+        return false;
+    }
+    visited[(position - start) * direction] = true;
+    current = position;
+    return true;
+}
+
+bool CoarseToFineSearch::seek(int position)
+{
+    int low = std::min(start, end);
+    int high = std::max(start, end);
+    position = std::max(low, std::min(position, high));
+    if (is_visited(position)) { return false; }
+
+    // Neighbours first, nearest first, before the rest of the refinement and of the sweep
+    int fine_step = step_plan.back();
+    std::deque<int> around;
+    for (int offset = fine_step; offset <= step_plan.front() / 2; offset += fine_step) {
+        for (int p : {position + offset, position - offset}) {
+            if (p >= low && p <= high) { around.push_back(p); }
+        }
+    }
+    refinement.insert(refinement.begin(), around.begin(), around.end());
+
+    visited[(position - start) * direction] = true;
+    current = position;
+    current_is_sweep = false;
+    has_previous_sweep = false; // The next output is not comparable to the one of the last sweep position
+    return true;
+}
+
+std::unique_ptr<RotationSearchStrategy> make_rotation_search(int start, int end, const std::vector<int>& step_plan)
+{
+    if (step_plan.empty() || (step_plan.size() == 1 && std::abs(step_plan[0]) <= 1)) {
+        return std::unique_ptr<RotationSearchStrategy>(new LinearSearch(start, end, 1));
+    }
+    return std::unique_ptr<RotationSearchStrategy>(new CoarseToFineSearch(start, end, step_plan));
+}
@@ -0,0 +1,297 @@
+// Simulates the rotation search to measure the number of frames (and motor travel) needed to lock on the bolt.
+//
+// Usage:
+// $ ros2 run image_subscriber rotation_search_sim [step_plan] [bolt_half_width] [near_half_width]
+//
+// step_plan is a comma separated list of steps (e.g. 32,8,1, default 1 i.e. the linear search). For every bolt
+// position of the range, the simulated NN returns the correct label within bolt_half_width motor units of the
+// bolt (default 2), another label within near_half_width units (default 10, the bolt partly in view) and the
+// background label elsewhere.
+// It also checks that, on a scene without bolt, each strategy reports the end of the range (the node then leaves
+// the search) within one frame per position, and restarts from the first position after reset(), also when crops
+// keep pointing at a bolt the whole frame never confirms (the crop moves of the node).
+// Last, it replays the search loop of the node in time without motion gating (camera frames, motor moves, position
+// read back, settle delay) on a synthetic scene, and checks that the frame-difference gate skips the inferences of
+// the unchanged frames of the settled positions while still locking on the bolt.
+// The exit status is 1 if a check fails.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "inference_gate.hpp"
+#include "motor_settle_tracker.hpp"
+#include "rotation_search.hpp"
+
+#define ROTATION_MOTOR_INIT_POS 400
+#define ROTATION_MOTOR_MAX_POS 0
+
+#define NN_CORRECT_LABEL 1
+#define NN_BACKGROUND_LABEL 0
+#define NN_NEAR_LABEL 2
+
+// Timed replay of the node search loop (times in ms, defaults of the node parameters)
+#define TIMED_FRAME_PERIOD_MS 33
+#define TIMED_MOVE_MS 20        // From the command to the arrival of the motor
+#define TIMED_READ_BACK_MS 5    // get_position round trip
+#define TIMED_SETTLE_DELAY_MS 30
+#define TIMED_SETTLE_TIMEOUT_MS 500
+#define TIMED_FRAME_WIDTH 64
+#define TIMED_FRAME_HEIGHT 48
+#define TIMED_FRAME_DIFF_THRESHOLD 2.0
+#define TIMED_BOLT 380
+
+struct SearchResult {
+    int frames;
+    int travel;
+    bool locked;
+};
+
+static SearchResult simulate(RotationSearchStrategy& search, int bolt, int bolt_half_width, int near_half_width)
+{
+    SearchResult result = {1, 0, false};
+    int position = search.reset();
+    for (;;) {
+        int distance = std::abs(position - bolt);
+        uint32_t nn_output = NN_BACKGROUND_LABEL;
+        if (distance <= bolt_half_width) {
+            result.locked = true;
+            return result;
+        }
+        if (distance <= near_half_width) { nn_output = NN_NEAR_LABEL; }
+
+        int next_position;
+        if (!search.next(nn_output, next_position)) { return result; }
+        result.travel += std::abs(next_position - position);
+        position = next_position;
+        result.frames++;
+    }
+}
+
+// Empty scene: next() must return false after at most one frame per position, without leaving the range
+static bool check_empty_scene(const char* name, RotationSearchStrategy& search)
+{
+    int positions = std::abs(ROTATION_MOTOR_INIT_POS - ROTATION_MOTOR_MAX_POS) + 1;
+    int low = std::min(ROTATION_MOTOR_INIT_POS, ROTATION_MOTOR_MAX_POS);
+    int high = std::max(ROTATION_MOTOR_INIT_POS, ROTATION_MOTOR_MAX_POS);
+    int first = search.reset();
+    int frames = 1;
+    int position;
+    while (search.next(NN_BACKGROUND_LABEL, position)) {
+        frames++;
+        if (frames > positions || position < low || position > high) {
+            printf("%-12s empty scene: search not exhausted after %d frames (position %d)\n", name, frames, position);
+            return false;
+        }
+    }
+    if (search.reset() != first) {
+        printf("%-12s empty scene: reset() after exhaustion does not restart the search\n", name);
+        return false;
+    }
+    printf("%-12s empty scene: exhausted after %d frames\n", name, frames);
+    return true;
+}
+
+// Multi-crop search of the node on a scene where the crops always see a bolt the whole frame does not confirm:
+// the crop offset points at phantom (or alternates around the position when phantom is -1). The search must
+// still end after at most one frame per position, crop moves included.
+static bool check_crop_false_positive(const char* name, RotationSearchStrategy& search, int phantom)
+{
+    int positions = std::abs(ROTATION_MOTOR_INIT_POS - ROTATION_MOTOR_MAX_POS) + 1;
+    int low = std::min(ROTATION_MOTOR_INIT_POS, ROTATION_MOTOR_MAX_POS);
+    int high = std::max(ROTATION_MOTOR_INIT_POS, ROTATION_MOTOR_MAX_POS);
+    int position = search.reset();
+    int frames = 1;
+    int crop_moves = 0;
+    for (;;) {
+        int crop_offset = (phantom >= 0) ? phantom - position : ((frames % 2) ? 5 : -5);
+        int target = std::max(low, std::min(position + crop_offset, high));
+        if (crop_offset != 0 && target != position && search.seek(target)) {
+            position = target;
+            crop_moves++;
+        }
+        else if (!search.next(NN_BACKGROUND_LABEL, position)) {
+            break;
+        }
+        frames++;
+        if (frames > positions) {
+            printf("%-12s crop false positive: search not exhausted after %d frames (position %d)\n", name, frames, position);
+            return false;
+        }
+    }
+    printf("%-12s crop false positive: exhausted after %d frames (%d crop moves)\n", name, frames, crop_moves);
+    return true;
+}
+
+struct TimedResult {
+    int frames;
+    int inferred;
+    int skipped;
+    bool locked;
+};
+
+// YUYV view of the scene at a motor position: a luma ramp that shifts with the rotation
+static void render_scene(int position, std::vector<uint8_t>& yuyv)
+{
+    yuyv.resize(TIMED_FRAME_WIDTH * TIMED_FRAME_HEIGHT * 2);
+    for (int row = 0; row < TIMED_FRAME_HEIGHT; row++) {
+        for (int col = 0; col < TIMED_FRAME_WIDTH; col++) {
+            uint8_t* pixel = &yuyv[(row * TIMED_FRAME_WIDTH + col) * 2];
+            pixel[0] = (uint8_t)((col + row + 4 * position) * 4);
+            pixel[1] = 128;
+        }
+    }
+}
+
+// search_step of the node without motion gating: every frame goes through the gate, the search only moves from
+// a frame captured once the motor settled (position read back, then the settle delay)
+static TimedResult simulate_timed(RotationSearchStrategy& search, double frame_diff_threshold)
+{
+    const int64_t ms = 1000000;
+    TimedResult result = {0, 0, 0, false};
+    MotorSettleTracker settle(0, TIMED_SETTLE_DELAY_MS * ms, TIMED_SETTLE_TIMEOUT_MS * ms);
+    InferenceGate gate(frame_diff_threshold);
+    std::vector<uint8_t> frame;
+
+    int position = search.reset();       // Where the motor is
+    int commanded = position;
+    int64_t arrival_ns = 0;
+    int64_t read_back_ns = -1;            // Pending get_position response, -1 if none
+    uint32_t nn_output = NN_BACKGROUND_LABEL;
+    int max_frames = 4 * std::abs(ROTATION_MOTOR_INIT_POS - ROTATION_MOTOR_MAX_POS) * (TIMED_MOVE_MS + TIMED_SETTLE_DELAY_MS) / TIMED_FRAME_PERIOD_MS;
+
+    for (int64_t now = 0; result.frames < max_frames; now += TIMED_FRAME_PERIOD_MS * ms) {
+        if (now >= arrival_ns) { position = commanded; }
+        if (read_back_ns >= 0 && now >= read_back_ns) {
+            // The position is read when the request is served, the motor may not have arrived yet
+            settle.position_read(settle.current_command(), (read_back_ns >= arrival_ns) ? commanded : position, read_back_ns);
+            read_back_ns = -1;
+        }
+        result.frames++;
+
+        render_scene(position, frame);
+        if (gate.reuse(frame.data(), TIMED_FRAME_WIDTH, TIMED_FRAME_HEIGHT, TIMED_FRAME_WIDTH * 2, settle)) {
+            result.skipped++;
+        }
+        else {
+            nn_output = (std::abs(position - TIMED_BOLT) <= 2) ? NN_CORRECT_LABEL : NN_BACKGROUND_LABEL;
+            gate.inferred(settle);
+            result.inferred++;
+        }
+        if (nn_output == NN_CORRECT_LABEL) {
+            result.locked = true;
+            return result;
+        }
+
+        // frame_after_settle(): read the position back while the motor is not known to be settled
+        settle.check_timeout(now);
+        if (!settle.settled()) {
+            if (read_back_ns < 0) { read_back_ns = now + TIMED_READ_BACK_MS * ms; }
+            continue;
+        }
+        if (!settle.frame_usable(now)) { continue; }
+
+        int next_position;
+        if (!search.next(nn_output, next_position)) { return result; }
+        commanded = next_position;
+        arrival_ns = now + TIMED_MOVE_MS * ms;
+        settle.command(commanded, now);
+    }
+    return result;
+}
+
+// The gate must skip frames without changing where the search locks
+static bool check_frame_gate(RotationSearchStrategy& search)
+{
+    TimedResult ungated = simulate_timed(search, 0);
+    TimedResult gated = simulate_timed(search, TIMED_FRAME_DIFF_THRESHOLD);
+    printf(
+        "timed search, bolt at %d: %d frames, %d inferred without gate, %d inferred and %d skipped with it\n",
+        TIMED_BOLT,
+        gated.frames,
+        ungated.inferred,
+        gated.inferred,
+        gated.skipped
+    );
+    if (!gated.locked || !ungated.locked || gated.frames != ungated.frames || gated.skipped == 0) {
+        printf("timed search: the frame-difference gate %s\n", gated.skipped == 0 ? "skipped no frame" : "changed the search");
+        return false;
+    }
+    return true;
+}
+
+static std::vector<int> parse_step_plan(const std::string& text)
+{
+    std::vector<int> step_plan;
+    std::stringstream ss(text);
+    std::string step;
+    while (std::getline(ss, step, ',')) {
+        step_plan.push_back(std::atoi(step.c_str()));
+    }
+    return step_plan;
+}
+
+static void report(const char* name, RotationSearchStrategy& search, int bolt_half_width, int near_half_width)
+{
+    std::vector<int> frames;
+    long total_travel = 0;
+    int missed = 0;
+    for (int bolt = ROTATION_MOTOR_MAX_POS; bolt <= ROTATION_MOTOR_INIT_POS; bolt++) {
+        SearchResult result = simulate(search, bolt, bolt_half_width, near_half_width);
+        if (!result.locked) {
+            missed++;
+            continue;
+        }
+        frames.push_back(result.frames);
+        total_travel += result.travel;
+    }
+    if (frames.empty()) {
+        printf("%-12s never locked\n", name);
+        return;
+    }
+    std::sort(frames.begin(), frames.end());
+    double mean = 0;
+    for (int f : frames) { mean += f; }
+    mean /= frames.size();
+    printf(
+        "%-12s %10.1f %10d %10d %14.1f %8d\n",
+        name,
+        mean,
+        frames[frames.size() * 95 / 100],
+        frames.back(),
+        (double)total_travel / frames.size(),
+        missed
+    );
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<int> step_plan = parse_step_plan((argc > 1) ? argv[1] : "1");
+    int bolt_half_width = (argc > 2) ? std::atoi(argv[2]) : 2;
+    int near_half_width = (argc > 3) ? std::atoi(argv[3]) : 10;
+
+    printf("Bolt half width %d, near half width %d, positions %d to %d\n\n",
+        bolt_half_width, near_half_width, ROTATION_MOTOR_INIT_POS, ROTATION_MOTOR_MAX_POS);
+    printf("%-12s %10s %10s %10s %14s %8s\n", "strategy", "mean", "p95", "max", "mean travel", "missed");
+
+    LinearSearch linear(ROTATION_MOTOR_INIT_POS, ROTATION_MOTOR_MAX_POS, 1);
+    report("linear", linear, bolt_half_width, near_half_width);
+
+    auto search = make_rotation_search(ROTATION_MOTOR_INIT_POS, ROTATION_MOTOR_MAX_POS, step_plan);
+    report((argc > 1) ? argv[1] : "1", *search, bolt_half_width, near_half_width);
+
+    printf("\n");
+    bool exhausted = check_empty_scene("linear", linear);
+    exhausted = check_empty_scene((argc > 1) ? argv[1] : "1", *search) && exhausted;
+    for (int phantom : {200, -1}) {
+        exhausted = check_crop_false_positive("linear", linear, phantom) && exhausted;
+        exhausted = check_crop_false_positive((argc > 1) ? argv[1] : "1", *search, phantom) && exhausted;
+    }
+
+    printf("\n");
+    bool gated = check_frame_gate(linear);
+    return (exhausted && gated) ? 0 : 1;
+}
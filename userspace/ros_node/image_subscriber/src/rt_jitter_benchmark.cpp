@@ -0,0 +1,147 @@
+// Measures the scheduling jitter of a periodic loop, with or without the real-time settings of the node.
+//
+// Usage:
+// $ ros2 run image_subscriber rt_jitter_benchmark [period_us] [iterations] [workload_us] [cpus] [priority]
+//
+// Every period the loop wakes up at an absolute deadline and runs workload_us of memory-bound work (the size of
+// a frame preprocessing). The wake-up latency (wake up - deadline) and the loop latency (end of the work -
+// deadline) are reported as percentiles. cpus is a comma-separated list ("" or "-": no pinning) and priority the
+// SCHED_FIFO priority (0: default policy, no memory locking); run it once each way under the same load.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "realtime.hpp"
+
+#define WORKLOAD_BUFFER_SIZE (640 * 480 * 2) // One YUYV frame
+
+static int64_t timespec_ns(const timespec& ts)
+{
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static timespec ns_timespec(int64_t ns)
+{
+    timespec ts;
+    ts.tv_sec = ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+    return ts;
+}
+
+static int64_t monotonic_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return timespec_ns(ts);
+}
+
+static std::vector<int> parse_cpus(const std::string& list)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string cpu;
+    while (std::getline(ss, cpu, ',')) {
+        if (!cpu.empty() && cpu != "-") { cpus.push_back(std::atoi(cpu.c_str())); }
+    }
+    return cpus;
+}
+
+// Sweeps the buffer until workload_ns elapsed
+static unsigned workload(std::vector<unsigned char>& buffer, int64_t workload_ns)
+{
+    unsigned sum = 0;
+    int64_t end_ns = monotonic_ns() + workload_ns;
+    size_t i = 0;
+    while (monotonic_ns() < end_ns) {
+        for (size_t j = 0; j < 4096; j++, i = (i + 1) % buffer.size()) {
+            buffer[i] = (unsigned char)(buffer[i] * 3 + 1);
+            sum += buffer[i];
+        }
+    }
+    return sum;
+}
+
+static void print_percentiles(const char* name, std::vector<int64_t>& samples_ns)
+{
+    std::sort(samples_ns.begin(), samples_ns.end());
+    auto percentile = [&samples_ns](double p) {
+        size_t index = std::min(samples_ns.size() - 1, (size_t)(p / 100.0 * samples_ns.size()));
+        return samples_ns[index] / 1000.0;
+    };
+    double sum = 0;
+    for (int64_t sample : samples_ns) {
+        sum += sample;
+    }
+    printf(
+        "%-14s min %8.1f  mean %8.1f  p50 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f us\n",
+        name,
+        samples_ns.front() / 1000.0,
+        sum / samples_ns.size() / 1000.0,
+        percentile(50),
+        percentile(99),
+        percentile(99.9),
+        samples_ns.back() / 1000.0
+    );
+}
+
+int main(int argc, char *argv[])
+{
+    int64_t period_ns = (int64_t)((argc > 1) ? std::atoi(argv[1]) : 1000) * 1000;
+    int iterations = (argc > 2) ? std::atoi(argv[2]) : 10000;
+    int64_t workload_ns = (int64_t)((argc > 3) ? std::atoi(argv[3]) : 200) * 1000;
+    RealtimeConfig config;
+    config.cpus = parse_cpus((argc > 4) ? argv[4] : "");
+    config.priority = (argc > 5) ? std::atoi(argv[5]) : 0;
+    config.prefault_heap_bytes = (size_t)RT_DEFAULT_PREFAULT_MB * 1024 * 1024;
+    if (period_ns <= 0 || iterations <= 0 || workload_ns < 0) {
+        fprintf(stderr, "Usage: %s [period_us] [iterations] [workload_us] [cpus] [priority]\n", argv[0]);
+        return 1;
+    }
+
+    std::string error;
+    if (config.priority > 0 && !lock_process_memory(config.prefault_heap_bytes, error)) {
+        fprintf(stderr, "Could not lock the memory: %s\n", error.c_str());
+        return 1;
+    }
+    if (!configure_realtime_thread(config, error)) {
+        fprintf(stderr, "Could not configure the thread: %s\n", error.c_str());
+        return 1;
+    }
+
+    std::vector<unsigned char> buffer(WORKLOAD_BUFFER_SIZE, 1);
+    std::vector<int64_t> wakeup_ns(iterations);
+    std::vector<int64_t> loop_ns(iterations);
+    unsigned checksum = 0;
+
+    int64_t deadline_ns = monotonic_ns() + period_ns;
+    for (int i = 0; i < iterations; i++) {
+        timespec deadline = ns_timespec(deadline_ns);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+        wakeup_ns[i] = monotonic_ns() - deadline_ns;
+        checksum += workload(buffer, workload_ns);
+        loop_ns[i] = monotonic_ns() - deadline_ns;
+
+        deadline_ns += period_ns;
+        // Overrun: restart from now instead of running late iterations back to back
+        int64_t now_ns = monotonic_ns();
+        if (deadline_ns < now_ns) { deadline_ns = now_ns + period_ns; }
+    }
+
+    printf(
+        "%d iterations, period %lld us, workload %lld us, %s, priority %d (checksum %u)\n",
+        iterations,
+        (long long)(period_ns / 1000),
+        (long long)(workload_ns / 1000),
+        config.cpus.empty() ? "not pinned" : "pinned",
+        config.priority,
+        checksum
+    );
+    print_percentiles("wake-up", wakeup_ns);
+    print_percentiles("loop", loop_ns);
+    return 0;
+}
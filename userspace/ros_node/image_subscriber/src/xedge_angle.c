@@ -0,0 +1,632 @@
+// ==============================================================
+// Vitis HLS - High-Level Synthesis from C, C++ and OpenCL v2020.2 (64-bit)
+// Copyright 1986-2020 Xilinx, Inc. All Rights Reserved.
+// ==============================================================
+/***************************** Include Files *********************************/
+#include "xedge_angle.h"
+
+/************************** Function Implementation *************************/
+#ifndef __linux__
+int XEdge_angle_CfgInitialize(XEdge_angle *InstancePtr, XEdge_angle_Config *ConfigPtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(ConfigPtr != NULL);
+
+    InstancePtr->Axi_cpu_BaseAddress = ConfigPtr->Axi_cpu_BaseAddress;
+    InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+
+    return XST_SUCCESS;
+}
+#endif
+
+void XEdge_angle_Start(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_AP_CTRL) & 0x80;
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_AP_CTRL, Data | 0x01);
+}
+
+u32 XEdge_angle_IsDone(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_AP_CTRL);
+    return (Data >> 1) & 0x1;
+}
+
+u32 XEdge_angle_IsIdle(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_AP_CTRL);
+    return (Data >> 2) & 0x1;
+}
+
+u32 XEdge_angle_IsReady(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_AP_CTRL);
+    // check ap_start to see if the pcore is ready for next input
+    return !(Data & 0x1);
+}
+
+void XEdge_angle_EnableAutoRestart(XEdge_angle *InstancePtr) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_AP_CTRL, 0x80);
+}
+
+void XEdge_angle_DisableAutoRestart(XEdge_angle *InstancePtr) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_AP_CTRL, 0);
+}
+
+u32 XEdge_angle_Get_return(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_AP_RETURN);
+    return Data;
+}
+void XEdge_angle_Set_frame(XEdge_angle *InstancePtr, u64 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_FRAME_DATA, (u32)(Data));
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_FRAME_DATA + 4, (u32)(Data >> 32));
+}
+
+u64 XEdge_angle_Get_frame(XEdge_angle *InstancePtr) {
+    u64 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_FRAME_DATA);
+    Data += (u64)XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_FRAME_DATA + 4) << 32;
+    return Data;
+}
+
+void XEdge_angle_Set_edges(XEdge_angle *InstancePtr, u64 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_EDGES_DATA, (u32)(Data));
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_EDGES_DATA + 4, (u32)(Data >> 32));
+}
+
+u64 XEdge_angle_Get_edges(XEdge_angle *InstancePtr) {
+    u64 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_EDGES_DATA);
+    Data += (u64)XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_EDGES_DATA + 4) << 32;
+    return Data;
+}
+
+void XEdge_angle_Set_stride(XEdge_angle *InstancePtr, u32 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_STRIDE_DATA, Data);
+}
+
+u32 XEdge_angle_Get_stride(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_STRIDE_DATA);
+    return Data;
+}
+
+void XEdge_angle_Set_roi_x(XEdge_angle *InstancePtr, u32 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_ROI_X_DATA, Data);
+}
+
+u32 XEdge_angle_Get_roi_x(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_ROI_X_DATA);
+    return Data;
+}
+
+void XEdge_angle_Set_roi_y(XEdge_angle *InstancePtr, u32 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_ROI_Y_DATA, Data);
+}
+
+u32 XEdge_angle_Get_roi_y(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_ROI_Y_DATA);
+    return Data;
+}
+
+void XEdge_angle_Set_roi_width(XEdge_angle *InstancePtr, u32 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_ROI_WIDTH_DATA, Data);
+}
+
+u32 XEdge_angle_Get_roi_width(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_ROI_WIDTH_DATA);
+    return Data;
+}
+
+void XEdge_angle_Set_roi_height(XEdge_angle *InstancePtr, u32 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_ROI_HEIGHT_DATA, Data);
+}
+
+u32 XEdge_angle_Get_roi_height(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_ROI_HEIGHT_DATA);
+    return Data;
+}
+
+void XEdge_angle_Set_threshold(XEdge_angle *InstancePtr, u32 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_THRESHOLD_DATA, Data);
+}
+
+u32 XEdge_angle_Get_threshold(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_THRESHOLD_DATA);
+    return Data;
+}
+
+void XEdge_angle_Set_theta_first(XEdge_angle *InstancePtr, u32 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_THETA_FIRST_DATA, Data);
+}
+
+u32 XEdge_angle_Get_theta_first(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_THETA_FIRST_DATA);
+    return Data;
+}
+
+void XEdge_angle_Set_theta_count(XEdge_angle *InstancePtr, u32 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_THETA_COUNT_DATA, Data);
+}
+
+u32 XEdge_angle_Get_theta_count(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_THETA_COUNT_DATA);
+    return Data;
+}
+
+void XEdge_angle_Set_hough_threshold(XEdge_angle *InstancePtr, u32 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_HOUGH_THRESHOLD_DATA, Data);
+}
+
+u32 XEdge_angle_Get_hough_threshold(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_HOUGH_THRESHOLD_DATA);
+    return Data;
+}
+
+void XEdge_angle_Set_debug_edges(XEdge_angle *InstancePtr, u32 Data) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_DEBUG_EDGES_DATA, Data);
+}
+
+u32 XEdge_angle_Get_debug_edges(XEdge_angle *InstancePtr) {
+    u32 Data;
+
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Data = XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_DEBUG_EDGES_DATA);
+    return Data;
+}
+
+u32 XEdge_angle_Get_line_theta_BaseAddress(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return (InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE);
+}
+
+u32 XEdge_angle_Get_line_theta_HighAddress(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return (InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_HIGH);
+}
+
+u32 XEdge_angle_Get_line_theta_TotalBytes(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE + 1);
+}
+
+u32 XEdge_angle_Get_line_theta_BitWidth(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return XEDGE_ANGLE_AXI_CPU_WIDTH_LINE_THETA;
+}
+
+u32 XEdge_angle_Get_line_theta_Depth(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return XEDGE_ANGLE_AXI_CPU_DEPTH_LINE_THETA;
+}
+
+u32 XEdge_angle_Write_line_theta_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length)*4 > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(int *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE + (offset + i)*4) = *(data + i);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Read_line_theta_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length)*4 > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(data + i) = *(int *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE + (offset + i)*4);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Write_line_theta_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length) > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(char *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE + offset + i) = *(data + i);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Read_line_theta_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length) > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(data + i) = *(char *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_THETA_BASE + offset + i);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Get_line_rho_BaseAddress(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return (InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE);
+}
+
+u32 XEdge_angle_Get_line_rho_HighAddress(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return (InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_HIGH);
+}
+
+u32 XEdge_angle_Get_line_rho_TotalBytes(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE + 1);
+}
+
+u32 XEdge_angle_Get_line_rho_BitWidth(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return XEDGE_ANGLE_AXI_CPU_WIDTH_LINE_RHO;
+}
+
+u32 XEdge_angle_Get_line_rho_Depth(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return XEDGE_ANGLE_AXI_CPU_DEPTH_LINE_RHO;
+}
+
+u32 XEdge_angle_Write_line_rho_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length)*4 > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(int *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE + (offset + i)*4) = *(data + i);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Read_line_rho_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length)*4 > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(data + i) = *(int *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE + (offset + i)*4);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Write_line_rho_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length) > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(char *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE + offset + i) = *(data + i);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Read_line_rho_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length) > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(data + i) = *(char *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_RHO_BASE + offset + i);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Get_line_votes_BaseAddress(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return (InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE);
+}
+
+u32 XEdge_angle_Get_line_votes_HighAddress(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return (InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_HIGH);
+}
+
+u32 XEdge_angle_Get_line_votes_TotalBytes(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE + 1);
+}
+
+u32 XEdge_angle_Get_line_votes_BitWidth(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return XEDGE_ANGLE_AXI_CPU_WIDTH_LINE_VOTES;
+}
+
+u32 XEdge_angle_Get_line_votes_Depth(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return XEDGE_ANGLE_AXI_CPU_DEPTH_LINE_VOTES;
+}
+
+u32 XEdge_angle_Write_line_votes_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length)*4 > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(int *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE + (offset + i)*4) = *(data + i);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Read_line_votes_Words(XEdge_angle *InstancePtr, int offset, word_type *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length)*4 > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(data + i) = *(int *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE + (offset + i)*4);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Write_line_votes_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length) > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(char *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE + offset + i) = *(data + i);
+    }
+    return length;
+}
+
+u32 XEdge_angle_Read_line_votes_Bytes(XEdge_angle *InstancePtr, int offset, char *data, int length) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr -> IsReady == XIL_COMPONENT_IS_READY);
+
+    int i;
+
+    if ((offset + length) > (XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_HIGH - XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE + 1))
+        return 0;
+
+    for (i = 0; i < length; i++) {
+        *(data + i) = *(char *)(InstancePtr->Axi_cpu_BaseAddress + XEDGE_ANGLE_AXI_CPU_ADDR_LINE_VOTES_BASE + offset + i);
+    }
+    return length;
+}
+
+void XEdge_angle_InterruptGlobalEnable(XEdge_angle *InstancePtr) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_GIE, 1);
+}
+
+void XEdge_angle_InterruptGlobalDisable(XEdge_angle *InstancePtr) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_GIE, 0);
+}
+
+void XEdge_angle_InterruptEnable(XEdge_angle *InstancePtr, u32 Mask) {
+    u32 Register;
+
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Register =  XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_IER);
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_IER, Register | Mask);
+}
+
+void XEdge_angle_InterruptDisable(XEdge_angle *InstancePtr, u32 Mask) {
+    u32 Register;
+
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    Register =  XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_IER);
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_IER, Register & (~Mask));
+}
+
+void XEdge_angle_InterruptClear(XEdge_angle *InstancePtr, u32 Mask) {
+    Xil_AssertVoid(InstancePtr != NULL);
+    Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    XEdge_angle_WriteReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_ISR, Mask);
+}
+
+u32 XEdge_angle_InterruptGetEnabled(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_IER);
+}
+
+u32 XEdge_angle_InterruptGetStatus(XEdge_angle *InstancePtr) {
+    Xil_AssertNonvoid(InstancePtr != NULL);
+    Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+    return XEdge_angle_ReadReg(InstancePtr->Axi_cpu_BaseAddress, XEDGE_ANGLE_AXI_CPU_ADDR_ISR);
+}
+